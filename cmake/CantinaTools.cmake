@@ -0,0 +1,38 @@
+# Builds a headless console executable from the same sources as the plugin.
+# The processor is compiled into the tool directly (no plugin wrapper), so the
+# JucePlugin_* macros the processor relies on are defined here by hand.
+function(cantina_add_tool TARGET_NAME)
+    juce_add_console_app(${TARGET_NAME}
+        PRODUCT_NAME "${TARGET_NAME}"
+    )
+
+    target_sources(${TARGET_NAME}
+        PRIVATE
+            ${CANTINA_SOURCES}
+            ${ARGN}
+    )
+
+    target_include_directories(${TARGET_NAME}
+        PRIVATE
+            ${CMAKE_CURRENT_SOURCE_DIR}/include
+            ${CMAKE_CURRENT_SOURCE_DIR}/include/UI
+    )
+
+    target_compile_definitions(${TARGET_NAME} PRIVATE
+        JucePlugin_Name="CantinaComposer"
+        JucePlugin_WantsMidiInput=1
+        JucePlugin_ProducesMidiOutput=0
+        JucePlugin_IsSynth=1
+        JUCE_WEB_BROWSER=0
+        JUCE_USE_CURL=0
+    )
+
+    target_link_libraries(${TARGET_NAME}
+        PRIVATE
+            juce::juce_audio_utils
+            juce::juce_dsp
+            juce::juce_recommended_config_flags
+            juce::juce_recommended_lto_flags
+            juce::juce_recommended_warning_flags
+    )
+endfunction()
@@ -1,51 +1,288 @@
 #pragma once
 #include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include <vector>
 
 /**
  * @class AudioBufferQueue
- * @brief A simple, thread-safe queue to transfer audio buffers between threads.
+ * @brief A lock-free, allocation-free ring buffer that keeps a history of the output.
  *
- * This class is designed to solve a common problem in audio plugins: how to get
- * data from the real-time audio thread (which cannot be blocked) to the UI/message
- * thread (which can be slower) for visualization. It uses a juce::CriticalSection
- * (a mutex) to ensure that reading and writing the buffer are mutually exclusive,
- * preventing data corruption.
+ * This class gets data from the real-time audio thread (which cannot be blocked)
+ * to the UI/message thread (which can be slower) for visualization. It is a
+ * single-producer/single-consumer ring of sample memory that is allocated once,
+ * in the constructor. The audio thread copies every block into the ring and then
+ * publishes the new write position with a release store. The UI thread reads the
+ * most recent samples straight out of the ring through a View, without locking
+ * and without copying.
+ *
+ * Next to the samples, the writer keeps a min/max peak pyramid: for every
+ * completed bucket of 16, 64, 256 and 1024 samples, one min/max pair per channel.
+ * The buckets are filled before the write position is published, so a reader can
+ * draw any zoom level with one column per pixel from a few hundred buckets,
+ * instead of walking every sample.
+ *
+ * Because the ring holds far more history than the UI ever looks at, the writer
+ * only overwrites samples a reader is looking at if the reader stalls for most of
+ * the history length. That is harmless for a visualization, so no further
+ * synchronization is done.
  * @ingroup Utilities
  */
 class AudioBufferQueue
 {
 public:
+    /// @brief The number of channels kept in the history.
+    static constexpr int maxChannels = 2;
+    /// @brief The history length in samples per channel. Must be a power of two.
+    static constexpr int capacity = 1 << 18; // ~5.4 seconds at 48 kHz
+    /// @brief The number of peak pyramid levels. Level l has buckets of 16 * 4^l samples.
+    static constexpr int numPeakLevels = 4;
+
     /**
-     * @brief Pushes a new audio buffer into the queue.
-     * This is called from the high-priority audio thread.
-     * @param buffer The audio buffer to be copied into the queue.
+     * @class View
+     * @brief A zero-copy view onto a range of the ring, split in two parts where it wraps.
      */
-    void push(const juce::AudioBuffer<float>& buffer)
+    struct View
     {
-        //TODO: Kein Lock verwenden..... aber es ist 5 Uhr morgens und die Stimmen werden lauter.
-        
-        // A ScopedLock ensures that the mutex is locked when this object is created
-        // and automatically unlocked when it goes out of scope. This is a safe way
-        // to prevent race conditions where the UI thread might try to read the
-        // buffer while the audio thread is writing to it.
-        const juce::ScopedLock lock(mutex);
-        latestBuffer = buffer;
+        const float* first = nullptr;
+        int firstSize = 0;
+        const float* second = nullptr;
+        int secondSize = 0;
+
+        int size() const noexcept { return firstSize + secondSize; }
+
+        float operator[](int index) const noexcept
+        {
+            return index < firstSize ? first[index] : second[index - firstSize];
+        }
+    };
+
+    AudioBufferQueue()
+        : history(maxChannels, capacity)
+    {
+        history.clear();
+
+        for (int level = 0; level < numPeakLevels; ++level)
+            for (auto& channelPeaks : peaks[(size_t) level])
+                channelPeaks.assign((size_t) (capacity / getBucketSize(level)), {});
     }
 
+    /** @brief Returns the number of samples per bucket of a pyramid level. */
+    static constexpr int getBucketSize(int level) noexcept { return 16 << (2 * level); }
+
     /**
-     * @brief Gets the latest audio buffer from the queue.
+     * @brief Stores the sample rate of the incoming audio, so readers can convert seconds to samples.
+     * Called from prepareToPlay.
+     */
+    void prepare(double newSampleRate) noexcept
+    {
+        sampleRate.store(newSampleRate, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Appends a new audio buffer to the history.
+     * This is called from the high-priority audio thread. It never locks and never allocates.
+     * @param buffer The audio buffer to be copied into the ring.
+     */
+    void push(const juce::AudioBuffer<float>& buffer) noexcept
+    {
+        const auto numChannels = juce::jmin(maxChannels, buffer.getNumChannels());
+        if (numChannels == 0)
+            return;
+
+        auto numSamples = buffer.getNumSamples();
+        auto sourceStart = 0;
+
+        // Only the tail of a block larger than the whole history can survive anyway.
+        if (numSamples > capacity)
+        {
+            sourceStart = numSamples - capacity;
+            numSamples = capacity;
+        }
+
+        const auto writePos = writePosition.load(std::memory_order_relaxed);
+        const auto start = static_cast<int>(writePos & mask);
+        const auto firstPart = juce::jmin(numSamples, capacity - start);
+
+        for (int channel = 0; channel < maxChannels; ++channel)
+        {
+            // Mono sources are mirrored so every channel of the history is valid.
+            const auto sourceChannel = juce::jmin(channel, numChannels - 1);
+            const auto* source = buffer.getReadPointer(sourceChannel, sourceStart);
+            history.copyFrom(channel, start, source, firstPart);
+
+            if (numSamples > firstPart)
+                history.copyFrom(channel, 0, source + firstPart, numSamples - firstPart);
+        }
+
+        const auto newWritePos = writePos + static_cast<juce::uint64>(numSamples);
+        updatePeaks(writePos, newWritePos);
+
+        writePosition.store(newWritePos, std::memory_order_release);
+    }
+
+    /**
+     * @brief Returns a view of the most recent samples of a channel.
      * This is called from the lower-priority UI thread.
-     * @return A copy of the latest audio buffer.
+     * @param channel The channel to look at.
+     * @param numSamples How many of the most recent samples to return. Clamped to what has been written.
      */
-    juce::AudioBuffer<float> getBuffer()
+    View getLatest(int channel, int numSamples) const noexcept
     {
-        const juce::ScopedLock lock(mutex);
-        return latestBuffer;
+        return getRange(channel, getTotalWritten(), numSamples);
     }
 
-    private:
-    /// @brief The mutex used to synchronize access to the buffer.
-    juce::CriticalSection mutex;
-    /// @brief The buffer that stores the latest block of audio data.
-    juce::AudioBuffer<float> latestBuffer;
+    /**
+     * @brief Returns a view of numSamples samples that end at the absolute position endPosition.
+     * @param channel The channel to look at.
+     * @param endPosition An absolute sample position, as returned by getTotalWritten().
+     * @param numSamples The length of the range. Clamped to the available history.
+     */
+    View getRange(int channel, juce::uint64 endPosition, int numSamples) const noexcept
+    {
+        View view;
+        numSamples = static_cast<int>(juce::jmin<juce::uint64>(static_cast<juce::uint64>(juce::jlimit(0, capacity, numSamples)), endPosition));
+
+        if (numSamples == 0 || ! juce::isPositiveAndBelow(channel, maxChannels))
+            return view;
+
+        const auto* data = history.getReadPointer(channel);
+        const auto start = static_cast<int>((endPosition - static_cast<juce::uint64>(numSamples)) & mask);
+
+        view.first = data + start;
+        view.firstSize = juce::jmin(numSamples, capacity - start);
+        view.second = data;
+        view.secondSize = numSamples - view.firstSize;
+        return view;
+    }
+
+    /**
+     * @brief Returns the absolute number of samples written so far.
+     * This doubles as a generation counter: it only changes when new audio has arrived.
+     */
+    juce::uint64 getTotalWritten() const noexcept { return writePosition.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Fills one min/max range per column for the numSamples samples that end at endPosition.
+     *
+     * Uses the coarsest pyramid level whose buckets still fit into a column, or the raw
+     * samples when a column is shorter than the smallest bucket. Only completed buckets
+     * are used, so the end of the range is rounded down to the bucket size.
+     * @param channel The channel to look at.
+     * @param endPosition An absolute sample position, as returned by getTotalWritten().
+     * @param numSamples The length of the range. Clamped to the available history.
+     * @param columns Receives numColumns ranges, oldest first. Columns without data are empty ranges.
+     * @param numColumns The number of columns, usually one per pixel.
+     */
+    void getPeaks(int channel, juce::uint64 endPosition, int numSamples, juce::Range<float>* columns, int numColumns) const noexcept
+    {
+        if (numColumns <= 0)
+            return;
+
+        std::fill(columns, columns + numColumns, juce::Range<float>());
+
+        if (numSamples <= 0 || ! juce::isPositiveAndBelow(channel, maxChannels))
+            return;
+
+        int level = -1;
+        while (level + 1 < numPeakLevels && getBucketSize(level + 1) * numColumns <= numSamples)
+            ++level;
+
+        // A unit is one raw sample, or one bucket of the chosen level.
+        const auto unitSize = (juce::uint64) (level < 0 ? 1 : getBucketSize(level));
+        const auto* samples = history.getReadPointer(channel);
+        const auto* buckets = level < 0 ? nullptr : peaks[(size_t) level][(size_t) channel].data();
+        const auto unitMask = level < 0 ? mask : (juce::uint64) (capacity / getBucketSize(level) - 1);
+
+        auto getUnit = [&](juce::uint64 unit)
+        {
+            if (buckets != nullptr)
+                return buckets[(size_t) (unit & unitMask)];
+
+            const auto value = samples[(size_t) (unit & unitMask)];
+            return juce::Range<float>(value, value);
+        };
+
+        // Only whole buckets are published, so end on a bucket boundary. Units from before the
+        // first write, or that have already been overwritten, leave their column empty.
+        const auto numUnits = (juce::int64) numSamples / (juce::int64) unitSize;
+        const auto endUnit = (juce::int64) (endPosition / unitSize);
+        const auto oldestUnit = juce::jmax((juce::int64) 0, endUnit - (juce::int64) (unitMask + 1) + 1);
+        const auto startUnit = endUnit - numUnits;
+
+        for (int c = 0; c < numColumns; ++c)
+        {
+            auto unit = startUnit + c * numUnits / numColumns;
+            const auto end = juce::jmax(unit + 1, startUnit + (c + 1) * numUnits / numColumns);
+
+            if (unit < oldestUnit)
+                continue;
+
+            auto range = getUnit((juce::uint64) unit);
+            for (++unit; unit < end; ++unit)
+                range = range.getUnionWith(getUnit((juce::uint64) unit));
+
+            columns[c] = range;
+        }
+    }
+
+    /** @brief Returns the sample rate passed to prepare(). */
+    double getSampleRate() const noexcept { return sampleRate.load(std::memory_order_relaxed); }
+
+private:
+    /**
+     * @brief Fills every pyramid bucket completed by the samples from oldWritePos to newWritePos.
+     * Level 0 is computed from the samples, every further level from four buckets of the one below.
+     */
+    void updatePeaks(juce::uint64 oldWritePos, juce::uint64 newWritePos) noexcept
+    {
+        for (int level = 0; level < numPeakLevels; ++level)
+        {
+            const auto bucketSize = (juce::uint64) getBucketSize(level);
+            const auto firstBucket = oldWritePos / bucketSize;
+            const auto endBucket = newWritePos / bucketSize;
+
+            for (int channel = 0; channel < maxChannels; ++channel)
+            {
+                auto& levelPeaks = peaks[(size_t) level][(size_t) channel];
+                const auto levelMask = (juce::uint64) levelPeaks.size() - 1;
+
+                // A huge block can complete more buckets than the ring holds; only the newest survive.
+                for (auto bucket = juce::jmax(firstBucket, endBucket - juce::jmin(endBucket, (juce::uint64) levelPeaks.size())); bucket < endBucket; ++bucket)
+                {
+                    juce::Range<float> range;
+
+                    if (level == 0)
+                    {
+                        const auto* data = history.getReadPointer(channel, (int) ((bucket * bucketSize) & mask));
+                        range = juce::FloatVectorOperations::findMinAndMax(data, (int) bucketSize);
+                    }
+                    else
+                    {
+                        const auto& lower = peaks[(size_t) level - 1][(size_t) channel];
+                        const auto lowerMask = (juce::uint64) lower.size() - 1;
+                        range = lower[(size_t) ((bucket * 4) & lowerMask)];
+                        for (juce::uint64 i = 1; i < 4; ++i)
+                            range = range.getUnionWith(lower[(size_t) ((bucket * 4 + i) & lowerMask)]);
+                    }
+
+                    levelPeaks[(size_t) (bucket & levelMask)] = range;
+                }
+            }
+        }
+    }
+
+    static constexpr juce::uint64 mask = static_cast<juce::uint64>(capacity - 1);
+    static_assert((capacity & (capacity - 1)) == 0, "The capacity must be a power of two");
+
+    /// @brief The preallocated sample memory of the ring.
+    juce::AudioBuffer<float> history;
+    /// @brief The min/max peak pyramid, per level and channel, each a ring of capacity / bucket size entries.
+    std::array<std::array<std::vector<juce::Range<float>>, maxChannels>, numPeakLevels> peaks;
+    /// @brief The absolute number of samples written, published by the audio thread.
+    std::atomic<juce::uint64> writePosition { 0 };
+    /// @brief The sample rate of the audio in the ring.
+    std::atomic<double> sampleRate { 44100.0 };
+
+    JUCE_DECLARE_NON_COPYABLE(AudioBufferQueue)
 };
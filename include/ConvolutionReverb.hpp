@@ -0,0 +1,98 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <memory>
+
+/**
+ * @class ConvolutionReverb
+ * @brief The convolution mode of the "Space Wobbler": real rooms, a plate and a spring instead of Freeverb.
+ *
+ * Four impulse responses are kept ready at all times, each in its own uniformly
+ * partitioned juce::dsp::Convolution. The partitions are the size of the prepared
+ * block and the latency is zero. Every response is trimmed or zero-padded to exactly
+ * maxImpulseSeconds, so all engines have the same number of partitions, and every
+ * full-size block costs the same: one forward and one inverse FFT plus one
+ * multiply-add per partition. Neither the selected response nor the length of the file on disk
+ * changes that, and there are no larger partitions that come due every few blocks.
+ *
+ * The responses are loaded once, at construction: from
+ * getImpulseResponseDirectory() if a WAV with the right name is there, otherwise
+ * generated. The partitioning happens on JUCE's loader thread, never on the audio thread.
+ *
+ * When "Chamber Size" picks another response, the input moves over to it across
+ * one block, and the old response rings out on silence in a single ring-out slot for
+ * up to maxImpulseSeconds. A later switch takes that slot over and cuts whatever
+ * tail is still ringing in it, so no block ever runs more than two engines.
+ *
+ * The existing knobs drive it: "Chamber Size" picks the response (small to large),
+ * "Damping" darkens the wet signal and "Width" scales its side channel. The engine
+ * is always fully wet: the processor mixes the dry signal back in per sample, with
+ * the same "Distance" ramp for both reverb modes.
+ * @ingroup Processor
+ */
+class ConvolutionReverb
+{
+public:
+    /// @brief The built-in responses, from the smallest to the largest space.
+    enum ImpulseResponse
+    {
+        spring,
+        cantina,
+        plate,
+        hall,
+        numImpulseResponses
+    };
+
+    /// @brief Every response is trimmed or padded to this length, which fixes the cost per block.
+    static constexpr double maxImpulseSeconds = 4.0;
+
+    ConvolutionReverb();
+
+    /** @brief Prepares all convolution engines and scratch buffers. Not realtime safe. */
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    /** @brief Clears the tails of all engines and the damping filter. */
+    void reset() noexcept;
+
+    /**
+     * @brief Applies the "Space Wobbler" knobs.
+     * @param roomSize "Chamber Size", selects the impulse response.
+     * @param damping Darkens the wet signal with a low-pass from 20 kHz down to 2 kHz.
+     * @param width The stereo width of the wet signal.
+     */
+    void setParameters(float roomSize, float damping, float width) noexcept;
+
+    /** @brief Replaces a block with its reverb, in place. */
+    void process(juce::dsp::AudioBlock<float>& block) noexcept;
+
+    /** @brief Returns the display name of a built-in response, which is also its file name on disk. */
+    static const char* getImpulseResponseName(int index) noexcept;
+    /** @brief The folder searched for user impulse responses (<name>.wav). */
+    static juce::File getImpulseResponseDirectory();
+
+private:
+    /** @brief Loads one response from disk, or generates it if there is no file, and pads it to maxImpulseSeconds. */
+    void loadImpulseResponse(int index, juce::AudioFormatManager& formats);
+    /** @brief Builds a decaying, decorrelated stereo noise response with the character of one of the spaces. */
+    static juce::AudioBuffer<float> generateImpulseResponse(int index, double sampleRate);
+
+    std::array<std::unique_ptr<juce::dsp::Convolution>, numImpulseResponses> engines;
+    /// @brief The response selected by "Chamber Size", and the one that rendered the previous block.
+    int selectedEngine = cantina;
+    int activeEngine = cantina;
+
+    /// @brief The "Damping" low-pass on the wet signal.
+    juce::dsp::StateVariableTPTFilter<float> dampingFilter;
+    float width = 1.0f;
+    double sampleRate = 44100.0;
+
+    /// @brief The response in the ring-out slot, or -1, and how many more samples it keeps ringing for.
+    int ringingEngine = -1;
+    int ringingSamples = 0;
+    /// @brief The longest tail of a response at the prepared sample rate, in samples.
+    int tailLength = 0;
+
+    /// @brief The wet signal, and the wet signal of the response that is ringing out.
+    juce::AudioBuffer<float> wetBuffer, fadeBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE(ConvolutionReverb)
+};
@@ -0,0 +1,155 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include "DspProfiler.hpp"
+
+/**
+ * @class DspLoadMeter
+ * @brief Always-on, lock-free timing of every processBlock stage, for the editor's load overlay.
+ *
+ * The audio thread times each stage and the whole block with the high resolution
+ * clock and collects the durations for about half a second of audio: count, sum,
+ * minimum, maximum and a log-spaced histogram for the 99th percentile. At the end
+ * of each window the results are published into atomics and the window starts
+ * over. The editor polls getStats() from its timer, so the two threads never
+ * share anything but those atomics.
+ *
+ * Load is the time spent relative to the time available, i.e. the length of the
+ * audio the blocks covered. The same ScopedStage also feeds an attached
+ * DspProfiler, so every stage is only timed once.
+ * @ingroup Utilities
+ */
+class DspLoadMeter
+{
+public:
+    using Stage = DspProfiler::Stage;
+
+    /// @brief One entry per stage, plus the whole block.
+    static constexpr int numEntries = DspProfiler::numStages + 1;
+    static constexpr int totalEntry = DspProfiler::numStages;
+
+    /** @brief The published statistics of one stage, in microseconds per block. */
+    struct Stats
+    {
+        float minMicros = 0.0f;
+        float meanMicros = 0.0f;
+        float p99Micros = 0.0f;
+        float maxMicros = 0.0f;
+        /// @brief Time spent in the stage as a percentage of the block deadline.
+        float loadPercent = 0.0f;
+    };
+
+    DspLoadMeter() = default;
+
+    /** @brief Sets the sample rate the deadlines are computed from and starts a new window. */
+    void prepare(double sampleRate) noexcept;
+
+    /** @brief Adds one run of a stage. Audio thread only. */
+    void addStage(Stage stage, juce::int64 elapsedTicks) noexcept { accumulate(static_cast<int>(stage), elapsedTicks); }
+    /** @brief Adds one whole block and publishes the window when it is full. Audio thread only. */
+    void addBlock(int numSamples, juce::int64 elapsedTicks) noexcept;
+
+    /** @brief Returns the statistics of the last full window. Safe to call from any thread. */
+    Stats getStats(int entry) const noexcept;
+    /** @brief Returns the worst single-block load of the last window, in percent. Safe to call from any thread. */
+    float getPeakLoadPercent() const noexcept { return peakLoadPercent.load(std::memory_order_relaxed); }
+
+    /** @brief Returns a short name for an entry: the stage name, or "total". */
+    static const char* getEntryName(int entry) noexcept
+    {
+        return entry == totalEntry ? "total" : DspProfiler::getStageName(static_cast<Stage>(entry));
+    }
+
+    /**
+     * @class ScopedStage
+     * @brief Times the enclosing scope as one stage, for the meter and an optional profiler.
+     */
+    class ScopedStage
+    {
+    public:
+        ScopedStage(DspLoadMeter& m, DspProfiler* p, Stage s) noexcept
+            : meter(m), profiler(p), stage(s), start(juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedStage()
+        {
+            const auto elapsed = juce::Time::getHighResolutionTicks() - start;
+            meter.addStage(stage, elapsed);
+            if (profiler != nullptr)
+                profiler->addTicks(stage, elapsed);
+        }
+
+    private:
+        DspLoadMeter& meter;
+        DspProfiler* profiler;
+        Stage stage;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedStage)
+    };
+
+    /**
+     * @class ScopedBlock
+     * @brief Times a whole processBlock call, for the meter and an optional profiler.
+     */
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock(DspLoadMeter& m, DspProfiler* p, int blockSize) noexcept
+            : meter(m), numSamples(blockSize), start(juce::Time::getHighResolutionTicks())
+        {
+            if (p != nullptr)
+                p->addBlock(blockSize);
+        }
+
+        ~ScopedBlock() { meter.addBlock(numSamples, juce::Time::getHighResolutionTicks() - start); }
+
+    private:
+        DspLoadMeter& meter;
+        int numSamples;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+private:
+    /// @brief Four histogram bins per octave, from 0.25us up to about 16ms.
+    static constexpr int binsPerOctave = 4;
+    static constexpr int numBins = 16 * binsPerOctave;
+    static constexpr double lowestBinMicros = 0.25;
+    static constexpr double windowSeconds = 0.5;
+
+    /** @brief The audio thread's running totals for one entry in the current window. */
+    struct Accumulator
+    {
+        juce::int64 count = 0;
+        juce::int64 sumTicks = 0;
+        juce::int64 minTicks = 0;
+        juce::int64 maxTicks = 0;
+        std::array<int, numBins> histogram {};
+    };
+
+    /** @brief The statistics of one entry as seen by the other threads. */
+    struct PublishedStats
+    {
+        std::atomic<float> minMicros { 0.0f }, meanMicros { 0.0f }, p99Micros { 0.0f }, maxMicros { 0.0f }, loadPercent { 0.0f };
+    };
+
+    void accumulate(int entry, juce::int64 elapsedTicks) noexcept;
+    /** @brief Turns the current window into published statistics and clears it. */
+    void publish() noexcept;
+
+    std::array<Accumulator, numEntries> accumulators;
+    std::array<PublishedStats, numEntries> published;
+    std::atomic<float> peakLoadPercent { 0.0f };
+
+    double sampleRate = 44100.0;
+    double ticksPerMicrosecond = 1.0;
+    juce::int64 windowSamples = 22050;
+    juce::int64 samplesInWindow = 0;
+    float windowPeakLoad = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE(DspLoadMeter)
+};
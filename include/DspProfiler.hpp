@@ -0,0 +1,92 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+
+/**
+ * @class DspProfiler
+ * @brief Accumulates the time spent in each stage of the processBlock chain.
+ *
+ * The processor only touches the profiler when one has been attached via
+ * CantinaComposerAudioProcessor::setProfiler(), so a plugin running in a host
+ * pays nothing more than a null check per stage. The benchmark attaches one to
+ * report ns/sample and realtime factors for every stage separately.
+ *
+ * The stages are timed by DspLoadMeter::ScopedStage, which feeds both the
+ * always-on load meter and this profiler, so every stage is only timed once.
+ * @ingroup Utilities
+ */
+class DspProfiler
+{
+public:
+    /** @brief The individual stages of processBlock, in signal flow order. */
+    enum class Stage
+    {
+        synth,
+        filterChain,
+        reverb,
+        gobbler,
+        visualizer,
+        numStages
+    };
+
+    static constexpr int numStages = static_cast<int>(Stage::numStages);
+
+    /** @brief Returns a short, human readable name for a stage. */
+    static const char* getStageName(Stage stage) noexcept
+    {
+        switch (stage)
+        {
+            case Stage::synth:       return "synth";
+            case Stage::filterChain: return "filterChain";
+            case Stage::reverb:      return "reverb";
+            case Stage::gobbler:     return "gobbler";
+            case Stage::visualizer:  return "visualizer";
+            default:                 return "?";
+        }
+    }
+
+    /** @brief Clears all accumulated timings. */
+    void reset() noexcept
+    {
+        ticks.fill(0);
+        numBlocks = 0;
+        numSamples = 0;
+    }
+
+    /** @brief Adds the duration of one stage run to the stage's total. */
+    void addTicks(Stage stage, juce::int64 elapsedTicks) noexcept
+    {
+        ticks[static_cast<size_t>(stage)] += elapsedTicks;
+    }
+
+    /** @brief Counts one processed block of the given length. */
+    void addBlock(int blockSize) noexcept
+    {
+        ++numBlocks;
+        numSamples += blockSize;
+    }
+
+    /** @brief Returns the total time spent in a stage since the last reset. */
+    double getSeconds(Stage stage) const noexcept
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks[static_cast<size_t>(stage)]);
+    }
+
+    /** @brief Returns the total time spent in all stages since the last reset. */
+    double getTotalSeconds() const noexcept
+    {
+        juce::int64 total = 0;
+        for (auto t : ticks)
+            total += t;
+        return juce::Time::highResolutionTicksToSeconds(total);
+    }
+
+    juce::int64 getNumBlocks() const noexcept { return numBlocks; }
+    juce::int64 getNumSamples() const noexcept { return numSamples; }
+
+private:
+    /// @brief Accumulated high resolution ticks per stage.
+    std::array<juce::int64, numStages> ticks {};
+    /// @brief Number of blocks and samples (per channel) processed since the last reset.
+    juce::int64 numBlocks = 0, numSamples = 0;
+};
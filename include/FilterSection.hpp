@@ -0,0 +1,55 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include "ParameterRamps.hpp"
+
+/**
+ * @class FilterSection
+ * @brief The low-pass and bass shelf of the "Filter & Tone Control" section.
+ *
+ * Both parameters come in as the ramps of ParameterRamps. While they move, the
+ * filters follow them every ParameterRamps::microBlockSize samples, without the
+ * zipper noise of a once-per-block update. While they rest, nothing is recomputed.
+ *
+ * The low-pass is a topology-preserving state-variable filter. Its coefficient is a
+ * single tan() that is recomputed in place, and only when the cutoff changed.
+ *
+ * The low-shelf is a biquad whose coefficients object is allocated once in prepare()
+ * and then overwritten in place, and only when the "Bass" gain actually changes.
+ * @ingroup Processor
+ */
+class FilterSection
+{
+public:
+    FilterSection() = default;
+
+    /** @brief Prepares both filters for playback. Not realtime safe. */
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    /** @brief Clears the filter states. */
+    void reset() noexcept;
+
+    /**
+     * @brief Filters a block in place.
+     * @param cutoff The "Frequency" of the low-pass in Hz, for every sample of the block.
+     * @param gain The "Bass" shelf gain in dB, for every sample of the block.
+     */
+    void process(juce::dsp::AudioBlock<float>& block, ParameterRamps::Ramp cutoff, ParameterRamps::Ramp gain) noexcept;
+
+private:
+    /** @brief Applies a cutoff to the state-variable filter, limited to below Nyquist. Only recomputes it if it changed. */
+    void applyCutoff(float cutoffHz) noexcept;
+    /** @brief Sets the shelf gain in dB. Recomputes the shelf only if the gain changed. */
+    void setBassGain(float newGainDecibels) noexcept;
+
+    /// @brief The "Frequency" low-pass, Butterworth resonance like the old IIR low-pass.
+    juce::dsp::StateVariableTPTFilter<float> lowPass;
+
+    /// @brief The "Bass" shelf, one filter per channel sharing one coefficients object.
+    using Shelf = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>;
+    Shelf lowShelf;
+    /// @brief The shelf gain the coefficients were last computed for.
+    float bassGain = 0.0f;
+
+    double sampleRate = 44100.0;
+
+    JUCE_DECLARE_NON_COPYABLE(FilterSection)
+};
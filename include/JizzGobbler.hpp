@@ -0,0 +1,78 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+
+/**
+ * @class JizzGobbler
+ * @brief The "Jizz Gobbler" distortion and bit-crusher as a vectorized kernel.
+ *
+ * The signal is driven into a rational tanh approximation and then quantized to a
+ * reduced number of levels. Everything that only depends on the "Intensity" knob
+ * (drive, number of levels and their reciprocal) is computed in setAmount() and
+ * only when the knob moves, so the per-sample work is a handful of multiplies,
+ * adds and compares, done for a whole SIMD register of samples at a time.
+ *
+ * processSample() runs the exact same operations on a single value. The static
+ * waveform preview uses it, so the preview matches the audio.
+ * @ingroup Processor
+ */
+class JizzGobbler
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    JizzGobbler() { setAmount(0.0f); }
+
+    /** @brief Sets the "Intensity" (0-1). Does nothing if it did not change. */
+    void setAmount(float newAmount) noexcept;
+
+    /** @brief Returns true if the effect changes the signal at all. */
+    bool isActive() const noexcept { return amount > 0.0f; }
+
+    /** @brief Crushes one sample. Bit-identical to what process() does with it. */
+    float processSample(float sample) const noexcept
+    {
+        const auto shaped = fastTanh(sample * drive);
+        return quantize(shaped * halfLevels + halfLevels) * levelStep - 1.0f;
+    }
+
+    /** @brief Crushes a run of samples in place. */
+    void process(float* samples, int numSamples) const noexcept;
+
+    /** @brief Crushes every channel of a block in place. */
+    void process(juce::dsp::AudioBlock<float>& block) const noexcept;
+
+    /**
+     * @brief Rational (Padé 7/6) approximation of tanh.
+     * The input is clamped to +-5 and the output to +-1; the absolute error stays below 1e-4.
+     */
+    static float fastTanh(float x) noexcept
+    {
+        x = juce::jlimit(-5.0f, 5.0f, x);
+        const auto x2 = x * x;
+        const auto numerator = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+        const auto denominator = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
+        return juce::jlimit(-1.0f, 1.0f, numerator / denominator);
+    }
+
+private:
+    /// @brief Adding and subtracting 2^23 rounds any float below 2^23 to the nearest integer.
+    static constexpr float roundingOffset = 8388608.0f;
+
+    /** @brief floor() for the non-negative values of the quantizer, using the same trick as the SIMD path. */
+    static float quantize(float x) noexcept
+    {
+        const auto rounded = (x + roundingOffset) - roundingOffset;
+        return rounded > x ? rounded - 1.0f : rounded;
+    }
+
+    static Vec fastTanh(Vec x) noexcept;
+    static Vec quantize(Vec x) noexcept;
+
+    float amount = -1.0f;
+    /// @brief The gain in front of the tanh, from 1x to 5x.
+    float drive = 1.0f;
+    /// @brief Half the number of quantizer levels, which maps -1..1 onto 0..levels.
+    float halfLevels = 32768.0f;
+    /// @brief 2 / levels, the reciprocal that maps the levels back onto -1..1.
+    float levelStep = 1.0f / 32768.0f;
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <vector>
+#include "ParameterSnapshot.hpp"
+
+/**
+ * @class LinearRamp
+ * @brief A linear ramp towards a target value that is written out for a whole chunk at once.
+ *
+ * Unlike juce::LinearSmoothedValue, nothing is computed per sample call: fill()
+ * writes every value of the chunk from its start, so the loop has no dependency
+ * between samples and vectorises. The ramp advances by exactly the samples it
+ * wrote, so a ramp takes the same time at any block size.
+ * @ingroup Processor
+ */
+class LinearRamp
+{
+public:
+    /** @brief Starts ramping from the current value to a new target. A running ramp to the same target continues. */
+    void setTarget(float newTarget, int rampLength) noexcept;
+    /** @brief Jumps to the target. */
+    void skip() noexcept { current = target; remaining = 0; }
+    /** @brief Writes the next numSamples values of the ramp and advances it by as many samples. */
+    void fill(float* destination, int numSamples) noexcept;
+
+    /** @brief Returns true while the ramp has not reached its target. */
+    bool isSmoothing() const noexcept { return remaining > 0; }
+    float getCurrentValue() const noexcept { return current; }
+    /** @brief Returns the highest value the ramp reaches from here. */
+    float getHighest() const noexcept { return juce::jmax(current, target); }
+
+private:
+    float current = 1.0f, target = 1.0f, step = 0.0f;
+    int remaining = 0;
+};
+
+/**
+ * @class ParameterRamps
+ * @brief Smooths the continuous effect parameters for every sample of a block.
+ *
+ * Once per block, fill() writes a ramp buffer for every parameter that is still
+ * moving towards its target. The effects then read per-sample values from get().
+ * A parameter that is not moving has no buffer: its Ramp carries only the value,
+ * so a stage can keep its coefficients and skip every recomputation until the
+ * knob moves again.
+ * @ingroup Processor
+ */
+class ParameterRamps
+{
+public:
+    /// @brief The smoothed parameters. The filter and bass entries are followed by one per layer.
+    enum Parameter : int
+    {
+        reverbRoomSize,
+        reverbWetLevel,
+        reverbDamping,
+        reverbWidth,
+        gobblerAmount,
+        /// @brief The output level as a linear gain.
+        outputGain,
+        filterFreq,
+        bassGain = filterFreq + InstrumentLayers::maxLayers,
+        numParameters = bassGain + InstrumentLayers::maxLayers
+    };
+
+    /// @brief How many samples a stage that cannot change every sample holds each ramp value for.
+    static constexpr int microBlockSize = 16;
+
+    /** @brief The values of one parameter for the current block. */
+    struct Ramp
+    {
+        /// @brief One value per sample while the parameter moves, nullptr while it doesn't.
+        const float* values = nullptr;
+        /// @brief The value at the end of the block.
+        float value = 0.0f;
+
+        bool isSmoothing() const noexcept { return values != nullptr; }
+        float operator[](int sample) const noexcept { return values != nullptr ? values[sample] : value; }
+    };
+
+    /** @brief Allocates the ramp buffers. Not realtime safe. */
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    /** @brief Sets the target of every parameter from a snapshot. Ramps only start for values that changed. */
+    void setTargets(const ParameterSnapshot& snapshot) noexcept;
+    /** @brief Jumps every parameter to its target. */
+    void reset() noexcept;
+
+    /** @brief Writes the ramps of the next numSamples samples, up to the prepared block size, for the moving parameters. */
+    void fill(int numSamples) noexcept;
+
+    /** @brief Returns the values of a parameter for the block of the last fill(). */
+    Ramp get(int parameter) const noexcept
+    {
+        const auto p = static_cast<size_t>(parameter);
+        return { smoothing[p] ? buffers.data() + p * static_cast<size_t>(maximumBlockSize) : nullptr, ramps[p].getCurrentValue() };
+    }
+
+private:
+    std::array<LinearRamp, numParameters> ramps {};
+    /// @brief Whether a parameter was moving in the last fill(), so its buffer holds that block.
+    std::array<bool, numParameters> smoothing {};
+    /// @brief One row of maximumBlockSize values per parameter.
+    std::vector<float> buffers;
+    int maximumBlockSize = 0;
+    int rampLength = 1;
+};
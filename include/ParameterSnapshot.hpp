@@ -0,0 +1,249 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <algorithm>
+#include <array>
+
+/**
+ * @class InstrumentLayers
+ * @brief Names the parameters of the instrument layers of the multi-timbral mode.
+ *
+ * Layer 0 plays from the main parameters ("WAVE", "ATTACK", ...), so a single-timbral
+ * patch simply is layer 0. Layers 1 to 3 have their own copy of every layer parameter,
+ * with the IDs prefixed "LAYER2_" to "LAYER4_". In multi-timbral mode, MIDI channel n
+ * plays layer n - 1. Everything that is not a layer parameter (pitch, reverb, distortion)
+ * is shared by all layers.
+ * @ingroup Processor
+ */
+class InstrumentLayers
+{
+public:
+    /// @brief The number of layers, one per MIDI channel 1-4.
+    static constexpr int maxLayers = 4;
+
+    /// @brief The main parameters every layer has its own copy of.
+    static constexpr std::array<const char*, 16> parameterIDs { "PRESET", "WAVE", "POLYPHONY", "UNISON", "UNISON_DETUNE",
+                                                                "ATTACK", "DECAY", "SUSTAIN", "RELEASE",
+                                                                "VOICE_CUTOFF", "VOICE_RESONANCE", "VOICE_ENV_AMOUNT",
+                                                                "VOICE_ENV_DECAY", "VOICE_KEYTRACK",
+                                                                "FILTER_FREQ", "BASS_GAIN" };
+
+    /** @brief Returns the ID of a layer's copy of a main parameter. Layer 0 uses the main ID itself. */
+    static juce::String getParameterID(const juce::String& mainID, int layer)
+    {
+        return layer == 0 ? mainID : "LAYER" + juce::String(layer + 1) + "_" + mainID;
+    }
+
+    /** @brief Returns true if every layer has its own copy of this main parameter. */
+    static bool isLayerParameter(const juce::String& mainID) noexcept
+    {
+        return std::any_of(parameterIDs.begin(), parameterIDs.end(), [&](const char* id) { return mainID == id; });
+    }
+};
+
+/**
+ * @struct LayerSnapshot
+ * @brief The parameter values of one instrument layer.
+ * @ingroup Processor
+ */
+struct LayerSnapshot
+{
+    int preset = 0;
+    int wave = 0;
+    int polyphony = 8;
+
+    // --- Unison ---
+    /// @brief The number of detuned oscillators every note stacks, 1 = no unison.
+    int unison = 1;
+    /// @brief The distance between the lowest and the highest oscillator of the stack, in cents.
+    float unisonDetune = 20.0f;
+
+    // --- Galactic Envelope (ADSR) ---
+    float attack = 0.1f;
+    float decay = 0.2f;
+    float sustain = 0.8f;
+    float release = 0.4f;
+
+    // --- Voice Filter (one low-pass per note) ---
+    /// @brief The cutoff in Hz at middle C, before the envelope. The top of the range switches the filter off.
+    float voiceCutoff = 20000.0f;
+    float voiceResonance = 0.707f;
+    /// @brief How far the filter envelope opens the cutoff at the start of a note, in octaves.
+    float voiceEnvAmount = 0.0f;
+    /// @brief The time constant of the filter envelope's decay, in seconds.
+    float voiceEnvDecay = 0.3f;
+    /// @brief How much the cutoff follows the note: 0 = not at all, 1 = one octave per octave.
+    float voiceKeytrack = 0.0f;
+
+    // --- Filter & Tone Control ---
+    float filterFreq = 20000.0f;
+    float bassGain = 0.0f;
+};
+
+/**
+ * @struct ParameterSnapshot
+ * @brief A plain copy of every parameter value, taken once per processed block.
+ *
+ * The processor fills one snapshot at the start of processBlock and hands it to
+ * the voices and effects, so nothing downstream has to look up parameters by
+ * name on the audio thread. Values are in their real (not normalised) ranges.
+ * @ingroup Processor
+ */
+struct ParameterSnapshot
+{
+    /// @brief True if MIDI channels 1-4 play one layer each, false if every channel plays layer 0.
+    bool multiTimbral = false;
+    /// @brief The sound of every layer. Only the first getNumLayers() are in use.
+    std::array<LayerSnapshot, InstrumentLayers::maxLayers> layers {};
+
+    /** @brief The number of layers that are playing. */
+    int getNumLayers() const noexcept { return multiTimbral ? InstrumentLayers::maxLayers : 1; }
+
+    /// @brief The "Blaster" pitch offset in semitones, shared by all layers.
+    float pitch = 0.0f;
+
+    // --- Space Wobbler (Reverb) ---
+    /// @brief 0 = classic (Freeverb), 1 = convolution.
+    int reverbMode = 0;
+    float reverbRoomSize = 0.5f;
+    float reverbWetLevel = 0.33f;
+    float reverbDamping = 0.5f;
+    float reverbWidth = 1.0f;
+
+    // --- Jizz Gobbler (Distortion) ---
+    float gobblerAmount = 0.0f;
+    /// @brief Oversampling around the gobbler: 0 = off, 1 = 2x, 2 = 4x, 3 = 8x.
+    int oversampling = 0;
+
+    /// @brief The output level in dB, applied after every effect.
+    float outputLevel = 0.0f;
+};
+
+/**
+ * @class ParameterHandles
+ * @brief Resolves the raw value pointers of all parameters once, at construction.
+ *
+ * The string-keyed apvts.getRawParameterValue() lookups happen here exactly once.
+ * Afterwards, load() only reads the cached atomics.
+ * @ingroup Processor
+ */
+class ParameterHandles
+{
+public:
+    explicit ParameterHandles(juce::AudioProcessorValueTreeState& apvts)
+        : multiTimbral(get(apvts, "MULTITIMBRAL")),
+          pitch(get(apvts, "PITCH")),
+          reverbMode(get(apvts, "REVERB_MODE")),
+          reverbRoomSize(get(apvts, "REVERB_ROOM_SIZE")),
+          reverbWetLevel(get(apvts, "REVERB_WET_LEVEL")),
+          reverbDamping(get(apvts, "REVERB_DAMPING")),
+          reverbWidth(get(apvts, "REVERB_WIDTH")),
+          gobblerAmount(get(apvts, "JIZZ_GOBBLER_AMOUNT")),
+          oversampling(get(apvts, "OVERSAMPLING")),
+          outputLevel(get(apvts, "OUTPUT_LEVEL"))
+    {
+        for (int l = 0; l < InstrumentLayers::maxLayers; ++l)
+        {
+            auto& layer = layers[(size_t) l];
+            auto getLayer = [&](const char* mainID) { return get(apvts, InstrumentLayers::getParameterID(mainID, l)); };
+
+            layer.preset = getLayer("PRESET");
+            layer.wave = getLayer("WAVE");
+            layer.polyphony = getLayer("POLYPHONY");
+            layer.unison = getLayer("UNISON");
+            layer.unisonDetune = getLayer("UNISON_DETUNE");
+            layer.attack = getLayer("ATTACK");
+            layer.decay = getLayer("DECAY");
+            layer.sustain = getLayer("SUSTAIN");
+            layer.release = getLayer("RELEASE");
+            layer.voiceCutoff = getLayer("VOICE_CUTOFF");
+            layer.voiceResonance = getLayer("VOICE_RESONANCE");
+            layer.voiceEnvAmount = getLayer("VOICE_ENV_AMOUNT");
+            layer.voiceEnvDecay = getLayer("VOICE_ENV_DECAY");
+            layer.voiceKeytrack = getLayer("VOICE_KEYTRACK");
+            layer.filterFreq = getLayer("FILTER_FREQ");
+            layer.bassGain = getLayer("BASS_GAIN");
+        }
+    }
+
+    /** @brief Copies the current value of every parameter into a snapshot. */
+    void load(ParameterSnapshot& snapshot) const noexcept
+    {
+        snapshot.multiTimbral = multiTimbral->load() > 0.5f;
+
+        for (size_t l = 0; l < layers.size(); ++l)
+        {
+            const auto& handles = layers[l];
+            auto& layer = snapshot.layers[l];
+
+            layer.preset = static_cast<int>(handles.preset->load());
+            layer.wave = static_cast<int>(handles.wave->load());
+            layer.polyphony = static_cast<int>(handles.polyphony->load());
+            layer.unison = static_cast<int>(handles.unison->load());
+            layer.unisonDetune = handles.unisonDetune->load();
+            layer.attack = handles.attack->load();
+            layer.decay = handles.decay->load();
+            layer.sustain = handles.sustain->load();
+            layer.release = handles.release->load();
+            layer.voiceCutoff = handles.voiceCutoff->load();
+            layer.voiceResonance = handles.voiceResonance->load();
+            layer.voiceEnvAmount = handles.voiceEnvAmount->load();
+            layer.voiceEnvDecay = handles.voiceEnvDecay->load();
+            layer.voiceKeytrack = handles.voiceKeytrack->load();
+            layer.filterFreq = handles.filterFreq->load();
+            layer.bassGain = handles.bassGain->load();
+        }
+
+        snapshot.pitch = pitch->load();
+        snapshot.reverbMode = static_cast<int>(reverbMode->load());
+        snapshot.reverbRoomSize = reverbRoomSize->load();
+        snapshot.reverbWetLevel = reverbWetLevel->load();
+        snapshot.reverbDamping = reverbDamping->load();
+        snapshot.reverbWidth = reverbWidth->load();
+        snapshot.gobblerAmount = gobblerAmount->load();
+        snapshot.oversampling = static_cast<int>(oversampling->load());
+        snapshot.outputLevel = outputLevel->load();
+    }
+
+private:
+    static std::atomic<float>* get(juce::AudioProcessorValueTreeState& apvts, const juce::String& parameterID)
+    {
+        auto* value = apvts.getRawParameterValue(parameterID);
+        jassert(value != nullptr); // Parameter missing from createParameterLayout()
+        return value;
+    }
+
+    /** @brief The parameters of one layer. */
+    struct LayerHandles
+    {
+        std::atomic<float>* preset = nullptr;
+        std::atomic<float>* wave = nullptr;
+        std::atomic<float>* polyphony = nullptr;
+        std::atomic<float>* unison = nullptr;
+        std::atomic<float>* unisonDetune = nullptr;
+        std::atomic<float>* attack = nullptr;
+        std::atomic<float>* decay = nullptr;
+        std::atomic<float>* sustain = nullptr;
+        std::atomic<float>* release = nullptr;
+        std::atomic<float>* voiceCutoff = nullptr;
+        std::atomic<float>* voiceResonance = nullptr;
+        std::atomic<float>* voiceEnvAmount = nullptr;
+        std::atomic<float>* voiceEnvDecay = nullptr;
+        std::atomic<float>* voiceKeytrack = nullptr;
+        std::atomic<float>* filterFreq = nullptr;
+        std::atomic<float>* bassGain = nullptr;
+    };
+
+    std::atomic<float>* multiTimbral;
+    std::atomic<float>* pitch;
+    std::atomic<float>* reverbMode;
+    std::atomic<float>* reverbRoomSize;
+    std::atomic<float>* reverbWetLevel;
+    std::atomic<float>* reverbDamping;
+    std::atomic<float>* reverbWidth;
+    std::atomic<float>* gobblerAmount;
+    std::atomic<float>* oversampling;
+    std::atomic<float>* outputLevel;
+    std::array<LayerHandles, InstrumentLayers::maxLayers> layers {};
+
+    JUCE_DECLARE_NON_COPYABLE(ParameterHandles)
+};
@@ -3,6 +3,7 @@
 #include "CustomLookAndFeel.hpp"
 #include "WaveformVisualizer.hpp"
 #include "StaticWaveformVisualizer.hpp"
+#include "LoadMeterOverlay.hpp"
 
 /**
  * @class CantinaComposerAudioProcessorEditor
@@ -27,12 +28,34 @@ public:
     
     /**
      * @brief Callback for when a ComboBox value changes.
-     * Used here to handle preset selection.
+     * Used here to handle preset and layer selection.
      * @param comboBoxThatHasChanged A pointer to the ComboBox that was changed.
      */
     void comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged) override;
 
 private:
+    /**
+     * @brief Opens the preset library menu: one entry per category. A category's presets are
+     * only put into a menu once it is picked, so a huge bank never builds one huge menu.
+     */
+    void showLibraryMenu();
+    /**
+     * @brief Opens the presets of one category, or first a menu of pages if there are too many.
+     * Takes the category by name and looks its presets up again when a page is picked, because
+     * opening or closing the user bank in between rebuilds the library's index.
+     */
+    void showCategoryMenu(const std::string& category);
+    /** @brief Opens a menu of presets[start..end), which loads the picked preset. */
+    void showPresetMenu(const std::vector<int>& presets, int start, int end);
+    /** @brief Returns a library preset's name as a juce::String. */
+    juce::String getPresetName(int index) const;
+
+    /** @brief Points the preset, waveform, envelope, unison, voice filter and tone controls at one instrument layer's parameters. */
+    void selectLayer(int layer);
+
+    /// @brief The most items shown in one (sub)menu of the library.
+    static constexpr int maxMenuItems = 100;
+
     // --- Type Aliases for cleaner code ---
     using APVTS = juce::AudioProcessorValueTreeState;
     using SliderAttachment = APVTS::SliderAttachment;
@@ -48,13 +71,25 @@ private:
     /// @brief The main title label for the plugin.
     juce::Label titleLabel;
 
+    /// @brief Switches the multi-timbral mode and picks the layer the sound controls edit.
+    juce::ToggleButton multiTimbralButton { "Multi-Timbral" };
+    std::unique_ptr<APVTS::ButtonAttachment> multiTimbralAttachment;
+    juce::ComboBox layerMenu;
+    /// @brief The layer the sound controls are attached to.
+    int selectedLayer = 0;
+
     /// @brief The live waveform visualizers.
     std::unique_ptr<StaticWaveformVisualizer> staticWaveformVisualizer;
     std::unique_ptr<WaveformVisualizer> waveformVisualizerRight;
 
+    /// @brief The per-stage DSP load overlay in the top right corner.
+    std::unique_ptr<LoadMeterOverlay> loadMeterOverlay;
+
     /// @brief UI controls for preset and waveform selection.
     juce::ComboBox presetMenu, waveMenu;
     std::unique_ptr<ComboBoxAttachment> presetAttachment, waveAttachment;
+    /// @brief Opens the whole preset library, factory and user bank, by category.
+    juce::TextButton libraryButton { "Library" };
 
     /// @brief UI controls for the "Galactic Envelope" (ADSR).
     juce::Slider attackSlider, decaySlider, sustainSlider, releaseSlider;
@@ -66,15 +101,33 @@ private:
     juce::Label freqLabel, bassLabel, blasterLabel;
     std::unique_ptr<SliderAttachment> freqAttachment, bassAttachment, blasterAttachment;
 
+    /// @brief UI controls for the unison stack: oscillators per note and their detune.
+    juce::Slider unisonSlider, detuneSlider;
+    juce::Label unisonLabel, detuneLabel;
+    std::unique_ptr<SliderAttachment> unisonAttachment, detuneAttachment;
+
+    /// @brief UI controls for the per-note low-pass and its envelope.
+    juce::Slider voiceCutoffSlider, voiceResonanceSlider, voiceEnvAmountSlider, voiceEnvDecaySlider, voiceKeytrackSlider;
+    juce::Label voiceFilterLabel, voiceCutoffLabel, voiceResonanceLabel, voiceEnvAmountLabel, voiceEnvDecayLabel, voiceKeytrackLabel;
+    std::unique_ptr<SliderAttachment> voiceCutoffAttachment, voiceResonanceAttachment, voiceEnvAmountAttachment,
+                                      voiceEnvDecayAttachment, voiceKeytrackAttachment;
+
     /// @brief UI controls for the "Space Wobbler" (Reverb) effect.
     juce::Slider chamberSlider, distanceSlider, dampingSlider, widthSlider;
     juce::Label spaceWobblerLabel, chamberLabel, distanceLabel, dampingLabel, widthLabel;
     std::unique_ptr<SliderAttachment> chamberAttachment, distanceAttachment, dampingAttachment, widthAttachment;
+    juce::ComboBox wobblerModeMenu;
+    std::unique_ptr<ComboBoxAttachment> wobblerModeAttachment;
 
     /// @brief UI control for the "Jizz Gobbler" (Distortion) effect.
     juce::Slider jizzGobblerSlider;
     juce::Label jizzGobblerLabel;
     std::unique_ptr<SliderAttachment> jizzGobblerAttachment;
+
+    /// @brief UI control for the output level, after every effect.
+    juce::Slider outputLevelSlider;
+    juce::Label outputLevelLabel;
+    std::unique_ptr<SliderAttachment> outputLevelAttachment;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CantinaComposerAudioProcessorEditor)
 };
\ No newline at end of file
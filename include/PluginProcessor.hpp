@@ -1,8 +1,18 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
-#include "SynthVoice.hpp"
+#include "VoiceDispatcher.hpp"
+#include "FilterSection.hpp"
+#include "JizzGobbler.hpp"
+#include "ConvolutionReverb.hpp"
+#include "VoiceRenderPool.hpp"
+#include "ParameterSnapshot.hpp"
+#include "ParameterRamps.hpp"
 #include "AudioBufferQueue.hpp"
+#include "DspProfiler.hpp"
+#include "DspLoadMeter.hpp"
+#include "PresetLibrary.hpp"
+#include "StateChunk.hpp"
 
 /**
  * @class CantinaComposerAudioProcessor
@@ -10,10 +20,15 @@
  *
  * This class manages the synthesizer, the effects chain (filter, reverb, distortion),
  * and all user-facing parameters via the AudioProcessorValueTreeState (APVTS).
+ * In multi-timbral mode, MIDI channels 1-4 play four instrument layers, each with
+ * its own sound parameters, voices and filter section, mixed onto one shared
+ * reverb and distortion bus.
  * It handles all interaction with the DAW/host.
  * @defgroup Processor Audio Processor
  */
-class CantinaComposerAudioProcessor : public juce::AudioProcessor
+class CantinaComposerAudioProcessor : public juce::AudioProcessor,
+                                      private juce::AudioProcessorValueTreeState::Listener,
+                                      private juce::AsyncUpdater
 {
 public:
     CantinaComposerAudioProcessor();
@@ -23,6 +38,17 @@ public:
     void releaseResources() override;
     void processBlock(juce::AudioBuffer<float> &, juce::MidiBuffer &) override;
 
+    /** @brief Switches between the realtime and the offline (bounce) strategy.
+     *  Offline renders prepare for large blocks, interpolate the wavetables with a cubic,
+     *  run the "Jizz Gobbler" at the highest oversampling and render voices on every core.
+     */
+    void setNonRealtime(bool isNonRealtime) noexcept override;
+
+    /** @brief Caps the voice worker threads of offline renders, for tools that run several instances side by side.
+     *  @param numWorkers The most extra threads per instance, or -1 for one per core (the default). Applied at the next prepareToPlay.
+     */
+    void setOfflineWorkerLimit(int numWorkers) noexcept { offlineWorkerLimit = numWorkers; }
+
     juce::AudioProcessorEditor *createEditor() override;
     bool hasEditor() const override { return true; }
 
@@ -30,7 +56,7 @@ public:
     bool acceptsMidi() const override { return JucePlugin_WantsMidiInput; }
     bool producesMidi() const override { return JucePlugin_ProducesMidiOutput; }
     bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 0.0; }
+    double getTailLengthSeconds() const override;
 
     int getNumPrograms() override { return 1; }
     int getCurrentProgram() override { return 0; }
@@ -44,33 +70,138 @@ public:
     juce::AudioProcessorValueTreeState apvts;
     /** @brief Applies parameter values for a selected preset.
      *  @param presetIndex The zero-based index of the preset to load.
+     *  @param layer The instrument layer to load it into; layer 0 also takes the shared parameters.
      */
-    void setPreset(int presetIndex);
+    void setPreset(int presetIndex, int layer = 0);
+
+    /** @brief The factory presets plus the user's preset bank. Message thread only. */
+    PresetLibrary& getPresetLibrary() noexcept { return presetLibrary; }
+    const PresetLibrary& getPresetLibrary() const noexcept { return presetLibrary; }
 
     /** @brief A queue to pass audio data safely from the audio thread to the UI thread for visualization. */
     AudioBufferQueue audioBufferQueue;
 
+    /** @brief Attaches a profiler that times every stage of processBlock, or detaches it when nullptr.
+     *  Must not be called while processBlock is running.
+     */
+    void setProfiler(DspProfiler* newProfiler) noexcept { profiler = newProfiler; }
+
+    /** @brief Returns the always-on per-stage load meter. Its statistics can be read from any thread. */
+    const DspLoadMeter& getLoadMeter() const noexcept { return loadMeter; }
+
 private:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
-    /** @brief Updates the filter parameters based on the current APVTS values. */
-    void updateFilters();
+    /** @brief Called when a listened-to parameter changes, possibly on the audio thread. */
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    /** @brief Starts or stops the voice worker threads and reports the latency on the message thread. */
+    void handleAsyncUpdate() override;
+    /** @brief Matches the number of voice worker threads to the "MULTICORE" parameter. Not realtime safe. */
+    void updateRenderPool();
+
+    /**
+     * @brief Tracks how long the effects have been ringing out without any input.
+     * @return True once the reverb tail has stayed below silenceThreshold for silenceHoldSamples.
+     */
+    bool updateSilence(const juce::AudioBuffer<float>& buffer, bool voicesSounding) noexcept;
+
+    /** @brief Reports the latency of the selected oversampling factor to the host. */
+    void updateLatency();
+    /** @brief Returns the oversampling that actually runs for an "OVERSAMPLING" choice: the highest while rendering offline. */
+    int getEffectiveOversampling(int choice) const noexcept;
+
+    /** @brief Runs the whole chain on one piece of at most maximumBlockSize samples of the host's block. */
+    void processChunk(juce::AudioBuffer<float>& fullBuffer, const juce::MidiBuffer& midiMessages, int startSample, int numSamples);
+
+    /** @brief Applies "Chamber Size", "Damping" and "Width" to both reverb engines, but only when one of them changed. */
+    void updateReverbSettings(float roomSize, float damping, float width) noexcept;
+    /**
+     * @brief Runs the active reverb engine fully wet over a block.
+     * While "Chamber Size", "Damping" or "Width" move, the engine follows their ramps every ParameterRamps::microBlockSize samples.
+     */
+    void processReverb(juce::dsp::AudioBlock<float>& block, int numSamples) noexcept;
+    /**
+     * @brief Runs the "Jizz Gobbler" over a block that may be oversampled.
+     * While the amount moves, it follows its ramp every ParameterRamps::microBlockSize samples of the host rate.
+     */
+    void processGobbler(juce::dsp::AudioBlock<float>& block, ParameterRamps::Ramp amount, int numSamples) noexcept;
+    /** @brief Returns true if none of the layer buses carries a signal above silenceThreshold. */
+    bool areLayersSilent(int numLayers, int numSamples) const noexcept;
+
+    /// @brief The factory presets and the memory-mapped user bank.
+    PresetLibrary presetLibrary { apvts };
+    /// @brief Reads and writes the binary host state.
+    StateChunk stateChunk { *this };
+
+    /// @brief Raw parameter pointers, resolved once so processBlock never looks parameters up by name.
+    ParameterHandles parameterHandles { apvts };
+    /// @brief The parameter values for the block currently being processed, shared with every voice.
+    ParameterSnapshot currentParams;
+    /// @brief Per-sample ramps of the continuous effect parameters of the snapshot.
+    ParameterRamps parameterRamps;
 
-    /// @brief The main synthesizer engine.
-    juce::Synthesiser synth;
+    /// @brief Optional worker threads that share the voice rendering of dense patches.
+    VoiceRenderPool renderPool;
+    /// @brief The state of all voices, rendered together in SIMD lanes.
+    VoiceBank voiceBank;
+    /// @brief The main synthesizer engine. Allocates notes to the voices of the bank.
+    VoiceDispatcher synth { voiceBank };
 
-    /// @brief The audio processing chain for the filter section.
-    using Filter = juce::dsp::IIR::Filter<float>;
-    using FilterChain = juce::dsp::ProcessorChain<Filter, Filter>;
-    FilterChain filterChain;
-    /// @brief A smoothed value for the filter frequency to prevent audio clicks.
-    juce::LinearSmoothedValue<float> smoothedFilterFreq;
+    /// @brief One mono bus per layer that the voices render into, before the layers are filtered and mixed.
+    juce::AudioBuffer<float> layerBuses;
+    /// @brief The filter section of every layer: low-pass and bass shelf, following their ramps.
+    std::array<FilterSection, InstrumentLayers::maxLayers> layerFilters;
 
     // --- Effects ---
     /// @brief The reverb module for the "Space Wobbler" effect.
     juce::dsp::Reverb reverb;
-    /// @brief The parameter block for the reverb module.
+    /// @brief The parameter block for the reverb module. It always runs fully wet.
     juce::dsp::Reverb::Parameters reverbParams;
+    /// @brief juce::dsp::Reverb scales its dry signal by 2 and its wet signal by 3. The dry mix of the
+    /// classic mode keeps that factor, so mixing outside the reverb sounds exactly like before.
+    static constexpr float classicDryScale = 2.0f;
+    /// @brief The reverb input, mixed back in along the "Distance" ramp.
+    juce::AudioBuffer<float> dryBuffer;
+    /// @brief The "Chamber Size", "Damping" and "Width" the reverb engines were last set to.
+    float appliedRoomSize = -1.0f, appliedDamping = -1.0f, appliedWidth = -1.0f;
+    /// @brief The convolution mode of the "Space Wobbler".
+    ConvolutionReverb convolutionReverb;
+    /// @brief The reverb mode that processed the previous block.
+    int activeReverbMode = 0;
+    /// @brief The "Jizz Gobbler" distortion and bit-crusher.
+    JizzGobbler gobbler;
+    /// @brief One oversampler per factor (2x, 4x, 8x) around the gobbler, all built in prepareToPlay
+    /// so switching the factor never allocates.
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, 3> oversamplers;
+    /// @brief The oversampling choice the audio thread is currently running.
+    int activeOversampling = 0;
+
+    // --- Offline rendering ---
+    /// @brief The block size offline renders are prepared for at least, so big bounce blocks run in one piece.
+    static constexpr int offlineMaximumBlockSize = 8192;
+    /// @brief The largest piece processChunk() handles, as prepared.
+    int maximumBlockSize = 512;
+    /// @brief Mirrors isNonRealtime() for the audio thread.
+    std::atomic<bool> offlineRender { false };
+    /// @brief The most voice workers an offline render may start, -1 for no limit.
+    int offlineWorkerLimit = -1;
+
+    // --- Silence detection ---
+    /// @brief The level below which the effects output counts as silence (-96 dB).
+    static constexpr float silenceThreshold = 1.5849e-5f;
+    /// @brief How long the output has to stay silent before the effects go to sleep. Longer than
+    /// the longest delay line inside juce::dsp::Reverb, so no energy can still be hiding in there.
+    static constexpr double silenceHoldSeconds = 0.1;
+    int silenceHoldSamples = 0;
+    /// @brief The number of consecutive samples without voices and with a silent reverb output.
+    int silentSamples = 0;
+    /// @brief True while processBlock skips the effects chain and outputs plain silence.
+    bool effectsAsleep = false;
+
+    /// @brief Optional stage profiler, only attached by the benchmark.
+    DspProfiler* profiler = nullptr;
+    /// @brief Times every stage of every block for the editor's load overlay.
+    DspLoadMeter loadMeter;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CantinaComposerAudioProcessor)
 };
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ParameterSnapshot.hpp"
+
+/**
+ * @class PresetLibrary
+ * @brief The factory presets plus an optional, memory-mapped bank of user presets.
+ *
+ * The factory presets are a static table. User presets live in one compact binary
+ * bank file, which is memory-mapped instead of read: opening even a bank with tens
+ * of thousands of presets only touches the pages the index needs.
+ *
+ * Bank layout (all integers little-endian uint32, floats little-endian IEEE):
+ * @code
+ *   header      "CCPB", version, numPresets, numParameters,
+ *               parameterIdsOffset, recordsOffset, stringsOffset, stringsSize
+ *   parameters  numParameters string offsets (parameter IDs)
+ *   records     numPresets x { nameOffset, categoryOffset, tagsOffset, float values[numParameters] }
+ *   strings     null-terminated UTF-8, referenced by offset into this block
+ * @endcode
+ * Records have a fixed stride, so loading preset n is one pointer computation and
+ * numParameters parameter writes, without any parsing. A NaN value leaves that
+ * parameter untouched. Tags are a comma-separated list.
+ *
+ * Opening a bank validates it once and builds hash indexes by name, category and
+ * tag. The index keys are string_views straight into the mapped file, so no
+ * strings are copied.
+ *
+ * Presets are numbered with the factory presets first, followed by the bank. A
+ * preset can be loaded into any instrument layer: layer 0 takes all of its values,
+ * the other layers only their copies of the layer parameters.
+ * @ingroup Processor
+ */
+class PresetLibrary
+{
+public:
+    /** @brief A preset as written by writeBank(). */
+    struct BankPreset
+    {
+        juce::String name, category, tags;
+        std::vector<std::pair<juce::String, float>> values;
+    };
+
+    explicit PresetLibrary(juce::AudioProcessorValueTreeState& apvts);
+
+    /** @brief Memory-maps a bank file and indexes it. Replaces any open bank. Returns false if it is invalid. */
+    bool openBank(const juce::File& bankFile);
+    /** @brief Unmaps the current bank, leaving only the factory presets. */
+    void closeBank();
+
+    /** @brief The bank that is opened at startup, if it exists. */
+    static juce::File getDefaultBankFile();
+
+    /** @brief Writes presets into a new bank file. Used by tooling and for exporting. */
+    static bool writeBank(const juce::File& bankFile, const std::vector<BankPreset>& presets);
+
+    int getNumPresets() const noexcept { return getNumFactoryPresets() + numBankPresets; }
+    static int getNumFactoryPresets() noexcept;
+    /** @brief The factory preset names, in order. These are the choices of the "PRESET" parameter. */
+    static juce::StringArray getFactoryPresetNames();
+
+    std::string_view getName(int index) const noexcept;
+    std::string_view getCategory(int index) const noexcept;
+    std::string_view getTags(int index) const noexcept;
+
+    /** @brief Returns the index of the preset with this name, or -1. */
+    int findByName(std::string_view name) const noexcept;
+    /** @brief Returns all categories, sorted. */
+    std::vector<std::string_view> getCategories() const;
+    /** @brief Returns the presets of a category in library order, or an empty list. */
+    const std::vector<int>& getPresetsInCategory(std::string_view category) const noexcept;
+    /** @brief Returns the presets carrying a tag in library order, or an empty list. */
+    const std::vector<int>& getPresetsWithTag(std::string_view tag) const noexcept;
+
+    /** @brief Applies a preset's values to the parameters of a layer. Returns false if the index or layer is out of range. */
+    bool applyPreset(int index, int layer = 0) const;
+
+private:
+    /** @brief Reads a little-endian uint32 of the mapped bank. */
+    juce::uint32 readUInt(size_t byteOffset) const noexcept;
+    /** @brief Returns a string of the bank's string block. Offsets were validated by openBank(). */
+    std::string_view getBankString(juce::uint32 offset) const noexcept;
+    /** @brief Returns the address of a bank record. */
+    const char* getRecord(int bankIndex) const noexcept;
+
+    /** @brief Returns a layer's copy of a parameter, or nullptr if the layer shares it with layer 0 or it doesn't exist. */
+    juce::RangedAudioParameter* getLayerParameter(const juce::String& parameterID, int layer) const;
+
+    /** @brief Adds one preset to the name, category and tag indexes. */
+    void addToIndex(int index);
+    /** @brief Rebuilds the indexes from the factory table and the open bank. */
+    void rebuildIndex();
+
+    juce::AudioProcessorValueTreeState& valueTreeState;
+
+    /// @brief The parameters the factory table sets, resolved once per layer.
+    std::array<std::vector<juce::RangedAudioParameter*>, InstrumentLayers::maxLayers> factoryParameters;
+
+    // --- The memory-mapped bank ---
+    std::unique_ptr<juce::MemoryMappedFile> bank;
+    const char* bankData = nullptr;
+    size_t bankSize = 0;
+    int numBankPresets = 0;
+    int numBankParameters = 0;
+    size_t recordsOffset = 0, recordStride = 0, stringsOffset = 0, stringsSize = 0;
+    /// @brief The parameters of the bank's value columns, resolved once per layer. nullptr for unknown or shared IDs.
+    std::array<std::vector<juce::RangedAudioParameter*>, InstrumentLayers::maxLayers> bankParameters;
+
+    // --- Indexes, keyed by views into the factory table or the mapped bank ---
+    std::unordered_map<std::string_view, int> nameIndex;
+    std::unordered_map<std::string_view, std::vector<int>> categoryIndex;
+    std::unordered_map<std::string_view, std::vector<int>> tagIndex;
+
+    JUCE_DECLARE_NON_COPYABLE(PresetLibrary)
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <vector>
+
+/**
+ * @class StateChunk
+ * @brief The compact binary form of the plugin state that the host stores in its sessions.
+ *
+ * Layout (little-endian):
+ * @code
+ *   "CCST", uint32 version, uint32 numEntries,
+ *   numEntries x { uint32 parameter ID hash, float value }
+ * @endcode
+ * Values are in their real (not normalised) ranges, so a state survives a change of a
+ * parameter's range. The entries are written in parameter layout order. Reading takes
+ * the fast path of matching them by position and only searches by hash when the
+ * layout has changed since the state was written. Parameters the chunk does not
+ * mention go back to their defaults.
+ *
+ * Writing sizes the host's block once and fills it in place, and reading writes
+ * straight into the parameters, so neither side builds a ValueTree or any XML, and
+ * reading allocates nothing at all.
+ * Sessions from before this format are XML; isStateChunk() tells them apart.
+ * @ingroup Processor
+ */
+class StateChunk
+{
+public:
+    static constexpr juce::uint32 currentVersion = 1;
+
+    /** @brief Collects the processor's parameters. They must all exist already. */
+    explicit StateChunk(juce::AudioProcessor& processor);
+
+    /** @brief The size of a chunk of the current version, in bytes. */
+    size_t getSize() const noexcept { return headerSize + entries.size() * entrySize; }
+
+    /** @brief Replaces the block's contents with a chunk of the current parameter values. */
+    void write(juce::MemoryBlock& destData) const;
+    /** @brief Applies a chunk to the parameters. Returns false, changing nothing, if it is not a valid chunk. */
+    bool read(const void* data, int sizeInBytes);
+
+    /** @brief True if the data starts like a binary chunk rather than a legacy XML state. */
+    static bool isStateChunk(const void* data, int sizeInBytes) noexcept;
+
+    /** @brief The stable 32-bit FNV-1a hash a parameter ID is stored as. */
+    static juce::uint32 hashParameterID(const juce::String& parameterID) noexcept;
+
+private:
+    static constexpr size_t headerSize = 3 * sizeof(juce::uint32);
+    static constexpr size_t entrySize = 2 * sizeof(juce::uint32);
+
+    struct Entry
+    {
+        juce::uint32 idHash;
+        juce::RangedAudioParameter* parameter;
+        /// @brief The position in the parameter layout.
+        size_t index;
+    };
+
+    /** @brief Finds a parameter by hash when the chunk's layout differs from ours. */
+    const Entry* find(juce::uint32 idHash) const noexcept;
+
+    /// @brief All parameters, in layout order.
+    std::vector<Entry> entries;
+    /// @brief The same entries, sorted by hash.
+    std::vector<Entry> sortedEntries;
+    /// @brief Which parameters the chunk being read has set, by layout position. Sized once, so reading never allocates.
+    std::vector<bool> restored;
+
+    JUCE_DECLARE_NON_COPYABLE(StateChunk)
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "DspLoadMeter.hpp"
+
+/**
+ * @class LoadMeterOverlay
+ * @brief A small overlay that shows the DSP load of every processBlock stage.
+ *
+ * Polls the processor's DspLoadMeter a few times per second and lists mean,
+ * 99th percentile and maximum time per block for each stage, plus each stage's
+ * share of the block deadline. When a session crackles, this shows which stage
+ * blew the budget. Clicking it toggles between the full table and a one-line summary.
+ * @ingroup UI
+ */
+class LoadMeterOverlay : public juce::Component,
+                         private juce::Timer
+{
+public:
+    explicit LoadMeterOverlay(const DspLoadMeter& meter);
+    ~LoadMeterOverlay() override;
+
+    void paint(juce::Graphics& g) override;
+    void mouseUp(const juce::MouseEvent&) override;
+
+    /** @brief Returns the height the overlay wants in its current (collapsed or expanded) state. */
+    int getPreferredHeight() const noexcept;
+
+private:
+    void timerCallback() override;
+
+    /// @brief The meter written by the audio thread. Only its atomics are read here.
+    const DspLoadMeter& loadMeter;
+    /// @brief The statistics shown, copied from the meter on every timer tick.
+    std::array<DspLoadMeter::Stats, DspLoadMeter::numEntries> stats;
+    float peakLoadPercent = 0.0f;
+    bool expanded = false;
+
+    static constexpr int rowHeight = 14;
+};
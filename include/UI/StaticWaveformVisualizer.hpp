@@ -1,35 +1,65 @@
 #pragma once
 #include <juce_audio_processors/juce_audio_processors.h>
+#include "JizzGobbler.hpp"
+#include "ParameterSnapshot.hpp"
 
 /**
  * @class StaticWaveformVisualizer
  * @brief A UI component that draws a static representation of the selected waveform.
  *
- * This class listens to parameter changes for the waveform type and the "Jizz Gobbler"
- * effect, and updates its display accordingly. It does not process live audio, but
+ * This class listens to parameter changes for the waveform type of the instrument layer
+ * being edited and the shared "Jizz Gobbler" effect, and updates its display accordingly. It does not process live audio, but
  * rather simulates the waveshaping effects to provide a clean visual preview.
+ *
+ * The curve is only computed when one of those parameters actually changes (or the
+ * component is resized) and is then kept as a rendered image, so paint() is a
+ * single blit. Parameter changes may arrive on any thread, including the audio
+ * thread during automation; they only store the new value and trigger an async
+ * update, which coalesces any number of changes into one rebuild on the message thread.
  * @ingroup UI
  */
 class StaticWaveformVisualizer : public juce::Component,
-                                 public juce::AudioProcessorValueTreeState::Listener
+                                 public juce::AudioProcessorValueTreeState::Listener,
+                                 private juce::AsyncUpdater
 {
 public:
     StaticWaveformVisualizer(juce::AudioProcessorValueTreeState& apvts);
     
     ~StaticWaveformVisualizer() override;
 
-    /** @brief The core JUCE paint callback where the static waveform is drawn. */
+    /** @brief The core JUCE paint callback. Draws the cached curve image. */
     void paint(juce::Graphics& g) override;
+    /** @brief Rebuilds the curve for the new size. */
+    void resized() override;
+
+    /** @brief Shows the waveform of another instrument layer. Call on the message thread. */
+    void setLayer(int newLayer);
 
-    /** @brief Called when a listened-to parameter changes. */
+    /** @brief Called when a listened-to parameter changes, possibly on the audio thread. */
     void parameterChanged(const juce::String& parameterID, float newValue) override;
 
 private:
+    /** @brief Rebuilds the curve on the message thread if the parameters changed since the last build. */
+    void handleAsyncUpdate() override;
+    /** @brief Computes the preview curve and renders it into curveImage. */
+    void rebuildCurve(float scale);
+
     /// @brief A reference to the main AudioProcessorValueTreeState.
     juce::AudioProcessorValueTreeState& valueTreeState;
+    /// @brief The instrument layer whose "WAVE" parameter is listened to.
+    int layer = 0;
+
+    /// @brief The latest parameter values, written from any thread.
+    std::atomic<int> currentWaveType { 0 };
+    std::atomic<float> gobblerAmount { 0.0f };
+
+    /// @brief The parameter values and pixel scale the cached curve was built for.
+    int builtWaveType = -1;
+    float builtGobblerAmount = -1.0f;
+    float builtScale = 0.0f;
 
-    /// @brief Caches the last selected wave type.
-    int currentWaveType = 0;
-    /// @brief Caches the last "Jizz Gobbler" amount.
-    float gobblerAmount = 0.0f;
+    /// @brief The same kernel the processor runs, so the preview matches the audio.
+    JizzGobbler gobbler;
+    /// @brief The rendered curve, at the physical pixel scale of the last paint.
+    juce::Image curveImage;
 };
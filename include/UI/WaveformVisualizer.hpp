@@ -8,8 +8,11 @@
  * @brief A UI component that draws a live representation of an audio signal.
  *
  * This class inherits from juce::Component to be a drawable element in the UI,
- * and from juce::Timer to periodically refresh its display. It reads audio data
- * from an AudioBufferQueue, which is safely fed by the real-time audio thread.
+ * and from juce::Timer to periodically check for new audio. It reads the min/max
+ * peak pyramid of an AudioBufferQueue, which is safely fed by the real-time audio
+ * thread, and draws one vertical column per pixel, so the drawing cost depends on
+ * the width of the component, not on how many samples are shown. It only repaints
+ * when the audio thread has published new samples. The mouse wheel zooms.
  * @defgroup UI User Interface
  */
 
@@ -25,12 +28,26 @@ public:
      * @param g The graphics context to draw into.
      */
     void paint(juce::Graphics& g) override;    
+    /** @brief Resizes the column cache to one entry per pixel. */
+    void resized() override;
+    /** @brief Zooms in or out by a factor of two per wheel step. */
+    void mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails& wheel) override;
     /**
      * @brief The callback for the juce::Timer. This is called periodically.
-     * Its sole purpose is to trigger a repaint of the component.
+     * Its sole purpose is to trigger a repaint when new audio has arrived.
      */
     void timerCallback() override;
 private:
+    /// @brief The zoom range: the number of most recent samples shown in the display.
+    static constexpr int minDisplaySamples = 256;
+    static constexpr int maxDisplaySamples = AudioBufferQueue::capacity / 2;
+    int displaySamples = 2048;
+
+    /// @brief The generation (total samples written) of the audio that was drawn last.
+    juce::uint64 drawnGeneration = 0;
+    /// @brief One min/max range per pixel column, reused for every frame.
+    std::vector<juce::Range<float>> columns;
+
     /// @brief A reference to the queue that safely transfers audio data from the audio thread.
     AudioBufferQueue& audioBufferQueue;
 };
\ No newline at end of file
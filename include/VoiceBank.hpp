@@ -0,0 +1,246 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+#include <vector>
+#include "ParameterSnapshot.hpp"
+#include "ParameterRamps.hpp"
+#include "WavetableBank.hpp"
+#include "VoiceRenderPool.hpp"
+
+/**
+ * @class VoiceBank
+ * @brief Holds the state of every synth voice in contiguous arrays and renders them in SIMD lanes.
+ *
+ * Instead of every voice rendering on its own into its own buffer, all oscillator
+ * phases, phase increments, envelope states and levels live side by side in
+ * structure-of-arrays form. Rendering walks the voices in groups of one SIMD
+ * register (4 or 8 voices, depending on the instruction set), advances the whole
+ * group with vector instructions and accumulates the group into a per-lane mix.
+ * The lanes are summed horizontally only once per sample at the very end, so the
+ * cost grows much slower than one renderNextBlock call per voice would. Groups
+ * without a sounding voice are skipped entirely.
+ *
+ * When a VoiceRenderPool is attached, the active groups are spread over its
+ * worker threads. Each group then renders into its own scratch mix and the
+ * scratch mixes are added up in group order, which is exactly the order of the
+ * serial render, so the output does not depend on the number of threads.
+ *
+ * Every voice can stack up to maxUnison detuned oscillators (unison). They are a
+ * phase-accumulator bank inside the voice: oscillator u of all voices of a group
+ * sits in one SIMD register, so a stack adds oscillator work only, while the
+ * envelope, level and mixing stay once per voice.
+ *
+ * Every voice also has its own low-pass, a TPT state-variable filter with its own
+ * decaying envelope and keytracking. Its two state variables live next to the other
+ * voice state, so the filters of a whole group run in the lanes of one register as
+ * well. Only the coefficients are computed per lane, once every
+ * filterUpdateInterval samples; a layer whose cutoff is fully open skips the filter.
+ *
+ * Pitch changes ("Blaster" glides and pitch bends) are sample-accurate. Each is a
+ * linear ramp of a frequency ratio that is written out for a whole chunk at once,
+ * one ramp buffer per layer, and every oscillator's increment is scaled by it per
+ * sample. So a glide takes the same time and shape at any block size, and costs
+ * one vector multiply per oscillator and sample.
+ *
+ * For the multi-timbral mode, the slots are split into equal partitions, one per
+ * instrument layer. A partition is a whole number of SIMD groups, so every group
+ * belongs to exactly one layer: all layers still render in the same pass, and each
+ * layer's lanes are summed into that layer's own mono bus.
+ *
+ * The envelope is the same linear attack/decay/sustain/release curve as juce::ADSR.
+ * Stage changes are detected with one vector comparison per sample and only the
+ * rare transition itself is handled per lane.
+ * @ingroup Processor
+ */
+class VoiceBank
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    /// @brief The number of voices rendered together in one SIMD register.
+    static constexpr int laneWidth = static_cast<int>(Vec::size());
+    /// @brief The maximum number of voices the bank can hold.
+    static constexpr int maxVoices = 128;
+    /// @brief The number of SIMD groups needed for maxVoices.
+    static constexpr int maxGroups = maxVoices / laneWidth;
+    /// @brief The most instrument layers the slots can be partitioned into.
+    static constexpr int maxLayers = InstrumentLayers::maxLayers;
+    static_assert(maxGroups % maxLayers == 0, "Every layer needs a whole number of SIMD groups");
+    /// @brief The most detuned oscillators a voice can stack.
+    static constexpr int maxUnison = 16;
+    /// @brief The number of samples between two updates of the voice filter coefficients.
+    static constexpr int filterUpdateInterval = 16;
+    /// @brief The voice cutoff at which the voice filter is switched off.
+    static constexpr float voiceFilterOpen = 20000.0f;
+
+    VoiceBank();
+
+    /** @brief Prepares the bank for playback. Allocates the per-lane mix scratch buffer. */
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    /** @brief Applies the parameters of the next block to every sounding voice, each from its own layer. */
+    void beginBlock(const ParameterSnapshot& snapshot) noexcept;
+
+    /**
+     * @brief Splits the slots into equal partitions for this many layers.
+     * Only call while every voice is idle: a sounding voice would change its layer.
+     */
+    void setNumLayers(int newNumLayers) noexcept { numLayers = juce::jlimit(1, maxLayers, newNumLayers); }
+    /** @brief Returns the number of layer partitions. */
+    int getNumLayers() const noexcept { return numLayers; }
+    /** @brief Returns the number of slots in each layer's partition. */
+    int getVoicesPerLayer() const noexcept { return maxVoices / numLayers; }
+    /** @brief Returns the layer a voice slot belongs to. */
+    int getLayerOfVoice(int voice) const noexcept { return voice / getVoicesPerLayer(); }
+
+    /**
+     * @brief Bends the pitch of every voice of a layer, ramping there over a few milliseconds.
+     * @param layer The layer to bend.
+     * @param semitones The bend, in semitones up or down.
+     */
+    void setPitchBend(int layer, float semitones) noexcept;
+
+    /** @brief Starts a note on a voice slot. */
+    void startVoice(int voice, int midiNoteNumber, float velocity) noexcept;
+    /** @brief Moves a voice slot into its release stage. */
+    void releaseVoice(int voice) noexcept;
+    /** @brief Silences a voice slot immediately. */
+    void killVoice(int voice) noexcept;
+
+    /** @brief Returns true if a voice slot is not producing any sound. */
+    bool isVoiceIdle(int voice) const noexcept { return stage[static_cast<size_t>(voice)] == idle; }
+    /** @brief Returns the current output amplitude of a voice slot (envelope times velocity level). */
+    float getVoiceAmplitude(int voice) const noexcept
+    {
+        const auto i = static_cast<size_t>(voice);
+        return envLevel[i] * level[i];
+    }
+
+    /**
+     * @brief Attaches a worker pool to spread the voice groups over, or nullptr to render serially.
+     * Must not be called while render() is running.
+     */
+    void setRenderPool(VoiceRenderPool* newPool) noexcept { pool = newPool; }
+
+    /** @brief Selects cubic instead of linear wavetable interpolation. Safe to call between blocks. */
+    void setHighQuality(bool shouldUseCubic) noexcept { highQuality.store(shouldUseCubic, std::memory_order_relaxed); }
+
+    /**
+     * @brief Renders all sounding voices and adds every layer to its own mono bus.
+     * @param layerMix One bus per layer to accumulate into, getNumLayers() of them.
+     * @param numSamples The number of samples to render.
+     */
+    void render(float* const* layerMix, int numSamples) noexcept;
+
+private:
+    /** @brief The envelope stage of a voice. */
+    enum EnvelopeStage : int
+    {
+        idle,
+        attack,
+        decay,
+        sustain,
+        release
+    };
+
+    /** @brief Renders up to maximumBlockSize samples of one SIMD group, adding it to mixTarget. */
+    void renderGroup(int group, int numSamples, Vec* mixTarget) noexcept;
+    /** @brief VoiceRenderPool task: renders the active group taskIndex into its own scratch mix. */
+    static void renderGroupTask(void* context, int taskIndex) noexcept;
+    /** @brief Moves a voice to the envelope stage after the one whose target it just reached. */
+    void advanceStage(int voice) noexcept;
+    /**
+     * @brief Computes the voice filter coefficients of one group for the next samples and decays its filter envelopes.
+     * @param numSamples The number of samples the coefficients are used for.
+     */
+    void updateFilterCoefficients(int group, int numSamples) noexcept;
+    /** @brief Returns a voice's cutoff before the filter envelope: the layer's cutoff, moved with the note by the keytracking. */
+    float getKeytrackedCutoff(int voice) const noexcept;
+    /** @brief Recomputes the oscillator increments and the wavetable of a voice from its base increment. */
+    void updateOscillators(int voice) noexcept;
+    /** @brief Sets the envelope segment of a voice. */
+    void setSegment(int voice, EnvelopeStage newStage, float rate, float target) noexcept;
+    /** @brief Returns the layer a SIMD group belongs to. */
+    int getLayerOfGroup(int group) const noexcept { return group / (maxGroups / numLayers); }
+    /** @brief Returns true if any voice of a group is sounding. */
+    bool isGroupActive(int group) const noexcept { return activeVoicesInGroup[static_cast<size_t>(group)] > 0; }
+
+    /// @brief The shared, precomputed wavetables.
+    juce::SharedResourcePointer<WavetableBank> wavetables;
+
+    // --- Per-voice state, one entry per voice (structure of arrays) ---
+    /// @brief The phase and increment of every unison oscillator, one row per oscillator index.
+    alignas(64) std::array<std::array<float, maxVoices>, maxUnison> unisonPhase {};
+    alignas(64) std::array<std::array<float, maxVoices>, maxUnison> unisonIncrement {};
+    /// @brief The increment of the note itself, without detune and pitch changes.
+    alignas(64) std::array<float, maxVoices> increment {};
+    alignas(64) std::array<float, maxVoices> envLevel {};
+    alignas(64) std::array<float, maxVoices> envRate {};
+    alignas(64) std::array<float, maxVoices> envTarget {};
+    alignas(64) std::array<float, maxVoices> envDirection {};
+    alignas(64) std::array<float, maxVoices> level {};
+    /// @brief The voice filter: the two integrator states, the coefficients of the current interval and the envelope.
+    alignas(64) std::array<float, maxVoices> filterState1 {};
+    alignas(64) std::array<float, maxVoices> filterState2 {};
+    alignas(64) std::array<float, maxVoices> filterA1 {};
+    alignas(64) std::array<float, maxVoices> filterA2 {};
+    alignas(64) std::array<float, maxVoices> filterA3 {};
+    std::array<float, maxVoices> filterEnv {};
+    std::array<float, maxVoices> voiceCutoff {};
+    std::array<float, maxVoices> noteFrequency {};
+    std::array<int, maxVoices> stage {};
+    std::array<const float*, maxVoices> table {};
+    /// @brief The number of sounding voices per SIMD group. Each group is only ever touched by one thread.
+    std::array<int, maxGroups> activeVoicesInGroup {};
+
+    /** @brief The envelope, waveform, unison and voice filter settings of one layer for the current block. */
+    struct LayerSettings
+    {
+        float attackRate = 0.0f, decayRate = 0.0f, sustainLevel = 1.0f, releaseSeconds = 0.4f;
+        int wave = 0;
+        int unison = 1;
+        /// @brief Keeps a stack about as loud as a single oscillator: 1 / sqrt(unison).
+        float unisonGain = 1.0f;
+        /// @brief The frequency ratio of every oscillator of the stack, spread evenly around 1.
+        std::array<float, maxUnison> detuneRatio {};
+        /// @brief The highest pitch ratio the layer reaches in this block, which picks the wavetables.
+        float tableRatio = 1.0f;
+        /// @brief False while the layer's voice cutoff is fully open.
+        bool voiceFilter = false;
+        float voiceCutoff = voiceFilterOpen, voiceKeytrack = 0.0f, voiceEnvAmount = 0.0f;
+        /// @brief The filter's damping, 1 / resonance.
+        float voiceDamping = 1.0f;
+        /// @brief The natural logarithm of the filter envelope's decay per sample.
+        float voiceEnvDecayPerSample = 0.0f;
+    };
+
+    // --- Per-layer settings of the current block and the pitch ramps ---
+    std::array<LayerSettings, maxLayers> layerSettings {};
+    int numLayers = 1;
+    /// @brief Glides to the "Blaster" pitch offset, shared by all layers.
+    LinearRamp blasterRamp;
+    /// @brief The pitch bend of every layer.
+    std::array<LinearRamp, maxLayers> bendRamps {};
+    /// @brief The ramp lengths in samples.
+    int glideLength = 1, bendLength = 1;
+    /// @brief The combined pitch ratio of every layer for every sample of the chunk, plus one row for the blaster ramp.
+    std::vector<float> pitchRamp;
+
+    /// @brief One SIMD register per sample that collects the lanes of all groups before the horizontal sum.
+    std::vector<Vec> laneMix;
+    /// @brief One scratch mix per group, only used when rendering on the pool.
+    std::vector<Vec> groupMix;
+    /// @brief The groups with a sounding voice in the chunk being rendered, in ascending order.
+    std::array<int, maxGroups> activeGroups {};
+    /// @brief The length of the chunk being rendered, for the pool tasks.
+    int chunkSize = 0;
+    /// @brief The optional worker pool.
+    VoiceRenderPool* pool = nullptr;
+    /// @brief Cubic wavetable interpolation, for offline renders.
+    std::atomic<bool> highQuality { false };
+    double sampleRate = 44100.0;
+    int maximumBlockSize = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(VoiceBank)
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include "SynthVoice.hpp"
+#include "VoiceBank.hpp"
+
+/**
+ * @class VoiceDispatcher
+ * @brief Allocates MIDI notes to the voices of a VoiceBank and renders them sample-accurately.
+ *
+ * This replaces juce::Synthesiser. Sounding voices are kept in an intrusive list
+ * ordered by age, so note-offs and voice stealing only ever look at voices that are
+ * actually playing, and idle voices cost nothing. Free voices are tracked in a bit
+ * mask and the lowest free slot is always taken first, which keeps the sounding
+ * voices packed into as few SIMD groups of the bank as possible.
+ *
+ * In multi-timbral mode, MIDI channels 1-4 each play their own instrument layer. Every
+ * layer has its own partition of the bank's slots, its own active list and its own
+ * polyphony, so a dense chord on one channel can only ever steal from that channel.
+ * Messages on channels without a layer are ignored. The pitch wheel bends a whole
+ * layer, so with a single layer, every channel's wheel bends every note.
+ *
+ * Incoming MIDI is parsed straight from the raw bytes. The block is only split where
+ * the timestamp actually changes, so a burst of events on the same sample costs one
+ * render call, not one per event.
+ * @ingroup Processor
+ */
+class VoiceDispatcher
+{
+public:
+    /// @brief The maximum polyphony, limited by the size of the bank.
+    static constexpr int maxVoices = VoiceBank::maxVoices;
+    /// @brief The maximum number of layers, one per MIDI channel 1-4.
+    static constexpr int maxLayers = VoiceBank::maxLayers;
+    /// @brief How far the pitch wheel bends, in semitones up and down.
+    static constexpr float pitchBendRange = 2.0f;
+
+    explicit VoiceDispatcher(VoiceBank& bank);
+
+    /** @brief Frees all voices immediately. Call after VoiceBank::prepare(). */
+    void reset() noexcept;
+
+    /**
+     * @brief Switches between a single layer that plays every MIDI channel and one layer per channel.
+     * Repartitions the bank, so every sounding voice is cut off. Does nothing if the count is unchanged.
+     */
+    void setNumLayers(int newNumLayers) noexcept;
+    /** @brief Returns the number of layers that are playing. */
+    int getNumLayers() const noexcept { return voiceBank.getNumLayers(); }
+
+    /** @brief Sets the maximum number of voices a layer may sound at once, up to its partition. New notes steal beyond it. */
+    void setPolyphony(int layer, int newPolyphony) noexcept
+    {
+        layers[(size_t) layer].polyphony = juce::jlimit(1, voiceBank.getVoicesPerLayer(), newPolyphony);
+    }
+
+    /** @brief Returns the number of voices currently sounding, including released ones. */
+    int getNumActiveVoices() const noexcept { return numActiveVoices; }
+    /** @brief Returns the number of voices of one layer currently sounding. */
+    int getNumActiveVoices(int layer) const noexcept { return layers[(size_t) layer].numActiveVoices; }
+
+    /**
+     * @brief Renders the voices for a block, applying each MIDI event at its exact sample position.
+     * @param layerMix One mono bus per layer to add the voices to. Sample 0 of every bus is startSample of the block.
+     * @param midiMessages The MIDI events for this block. Only those inside the rendered range are applied.
+     * @param startSample The first sample of the block to render.
+     * @param numSamples The number of samples to render.
+     */
+    void renderNextBlock(float* const* layerMix, const juce::MidiBuffer& midiMessages,
+                         int startSample, int numSamples) noexcept;
+
+private:
+    /** @brief Applies one raw MIDI message. */
+    void handleMidiEvent(const juce::uint8* data, int numBytes) noexcept;
+    void noteOn(int midiChannel, int midiNoteNumber, float velocity) noexcept;
+    void noteOff(int midiChannel, int midiNoteNumber) noexcept;
+    void sustainPedal(int midiChannel, bool isDown) noexcept;
+    /** @brief Bends the layer of a channel. wheelValue is the 14-bit wheel position, 8192 is the centre. */
+    void pitchWheel(int midiChannel, int wheelValue) noexcept;
+    void allNotesOff(int midiChannel, bool allowTailOff) noexcept;
+
+    /** @brief Renders a range of the block without any MIDI events in it, offset samples into the buses. */
+    void renderSegment(float* const* layerMix, int offset, int numSamples) noexcept;
+
+    /** @brief The sounding voices of one layer. */
+    struct Layer
+    {
+        /// @brief The intrusive list of sounding voices, oldest first.
+        SynthVoice* activeHead = nullptr;
+        SynthVoice* activeTail = nullptr;
+        int numActiveVoices = 0;
+        int polyphony = 8;
+    };
+
+    /** @brief Returns the layer that plays a MIDI channel, or -1 if none does. */
+    int getLayerOfChannel(int midiChannel) const noexcept;
+    /** @brief Returns the layer a voice belongs to, from its slot. */
+    Layer& getLayer(const SynthVoice& voice) noexcept { return layers[(size_t) voiceBank.getLayerOfVoice(voice.slot)]; }
+
+    /** @brief Takes a free voice of a layer's partition, or steals one if the layer's polyphony is used up. */
+    SynthVoice* allocateVoice(int layerIndex) noexcept;
+    /** @brief Picks the voice of a layer to steal: the quietest released voice, or else the oldest one. */
+    SynthVoice* findVoiceToSteal(const Layer& layer) const noexcept;
+    /** @brief Moves voices whose release has finished in the bank back to the free mask. */
+    void retireFinishedVoices() noexcept;
+    /** @brief Unlinks a voice from the active list and marks its slot as free. */
+    void freeVoice(SynthVoice& voice) noexcept;
+
+    VoiceBank& voiceBank;
+    std::array<SynthVoice, maxVoices> voices;
+
+    std::array<Layer, maxLayers> layers {};
+    /// @brief The number of sounding voices of all layers together.
+    int numActiveVoices = 0;
+
+    /// @brief One bit per free slot, so the lowest free slot is found with a single instruction.
+    std::array<juce::uint64, maxVoices / 64> freeMask {};
+
+    std::array<bool, 17> sustainPedalDown {};
+
+    JUCE_DECLARE_NON_COPYABLE(VoiceDispatcher)
+};
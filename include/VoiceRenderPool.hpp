@@ -0,0 +1,95 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <memory>
+
+/**
+ * @class VoiceRenderPool
+ * @brief An optional pool of real-time worker threads that share the voice rendering of a block.
+ *
+ * The audio thread publishes a job of numTasks independent tasks (one per active
+ * SIMD voice group) and then works on it itself. Every participant owns a range
+ * of the tasks: it takes tasks from the front of its own range and, once that is
+ * empty, steals from the back of the others. Ranges are single packed atomics
+ * updated with compare-and-swap, so no participant ever takes a lock.
+ *
+ * The audio thread never waits for a sleeping worker: it simply does the tasks
+ * nobody claimed. It only spins for tasks another worker is already running.
+ * Workers spin for a fraction of a millisecond after their last task and park
+ * afterwards, so between blocks and in a pool that is not used they cost nothing. Parked workers wait on an atomic, so waking them is a
+ * futex-style notify that never takes a lock on the audio thread. With zero
+ * workers, run() executes all tasks inline.
+ *
+ * Task results must not depend on which thread ran them; the caller combines
+ * them in a fixed order so the output is bit-identical to a serial render.
+ * @ingroup Processor
+ */
+class VoiceRenderPool
+{
+public:
+    /** @brief The function executed for every task of a job. */
+    using TaskFunction = void (*)(void* context, int taskIndex);
+
+    /// @brief The maximum number of worker threads (the audio thread comes on top).
+    static constexpr int maxWorkers = 31;
+
+    VoiceRenderPool();
+    ~VoiceRenderPool();
+
+    /**
+     * @brief Starts or stops worker threads.
+     * Must be called from a non-realtime thread. Safe while the audio thread is using the pool.
+     * @param numWorkers The number of extra threads, clamped to maxWorkers. 0 renders everything on the audio thread.
+     */
+    void setNumWorkers(int numWorkers);
+
+    /**
+     * @brief Pins every worker to its own core, skipping core 0, or lets the OS schedule them freely.
+     * Off by default: a plugin cannot know which core the host's audio thread runs on, and a worker
+     * pinned to that core would compete with it. Offline renders, which own the machine, pin.
+     * The workers apply it before their next job.
+     */
+    void setPinnedToCores(bool shouldPin) noexcept { pinnedToCores.store(shouldPin, std::memory_order_relaxed); }
+
+    /** @brief Returns the number of running worker threads. */
+    int getNumWorkers() const noexcept { return numRunningWorkers.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Runs numTasks tasks across the audio thread and the workers and returns once all are done.
+     * Called from the audio thread only. Never allocates and never locks.
+     */
+    void run(int numTasks, TaskFunction function, void* context) noexcept;
+
+private:
+    class Worker;
+
+    /** @brief Packs a job generation and a [begin, end) task range into one atomic word. */
+    static juce::uint64 pack(juce::uint32 tag, juce::uint32 begin, juce::uint32 end) noexcept
+    {
+        return (static_cast<juce::uint64>(tag) << 32) | (static_cast<juce::uint64>(begin & 0xffff) << 16) | (end & 0xffff);
+    }
+
+    /** @brief Takes the next task from the front of a participant's own range, or returns -1. */
+    int popFront(int queue, juce::uint32 tag) noexcept;
+    /** @brief Takes a task from the back of another participant's range, or returns -1. */
+    int stealBack(int queue, juce::uint32 tag) noexcept;
+    /** @brief Works on the job of the given generation until no task is left to claim. */
+    void participate(int queue, juce::uint32 tag) noexcept;
+
+    /// @brief One task range per participant. Queue 0 belongs to the audio thread.
+    std::array<std::atomic<juce::uint64>, maxWorkers + 1> ranges;
+    /// @brief The current job.
+    std::atomic<TaskFunction> jobFunction { nullptr };
+    std::atomic<void*> jobContext { nullptr };
+    std::atomic<int> tasksRemaining { 0 };
+    std::atomic<juce::uint32> generation { 0 };
+    /// @brief The number of queues the current job was split into.
+    std::atomic<int> numQueues { 1 };
+
+    std::array<std::unique_ptr<Worker>, maxWorkers> workers;
+    std::atomic<int> numRunningWorkers { 0 };
+    std::atomic<bool> pinnedToCores { false };
+
+    JUCE_DECLARE_NON_COPYABLE(VoiceRenderPool)
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <vector>
+
+/**
+ * @class WavetableBank
+ * @brief A shared bank of precomputed, band-limited single-cycle wavetables.
+ *
+ * For every waveform (Sine, Saw, Square) the bank holds one table per octave.
+ * Each table only contains the harmonics that stay below Nyquist for the
+ * highest frequency it is used for, so high notes do not alias. The bank is
+ * built once, when the first instance is created, and shared between all
+ * plugin instances through a juce::SharedResourcePointer. Voices pick a table
+ * by waveform and phase increment, so switching waveforms on the audio thread
+ * is nothing more than a pointer swap.
+ * @ingroup Processor
+ */
+class WavetableBank
+{
+public:
+    /// @brief The number of samples per cycle. Every table has one guard sample in front and two
+    /// behind, so both interpolators can read their neighbours without wrapping.
+    static constexpr int tableSize = 2048;
+    /// @brief The number of harmonics in the richest table. Each following table halves it.
+    static constexpr int maxHarmonics = 512;
+    /// @brief The number of octave tables per waveform (512, 256, ..., 1 harmonics).
+    static constexpr int numTables = 10;
+    /// @brief The number of waveforms, matching the "WAVE" parameter choices.
+    static constexpr int numWaveforms = 3;
+
+    /** @brief Builds all tables. This is expensive and happens once per process. */
+    WavetableBank();
+
+    /**
+     * @brief Returns the table to play a waveform at the given phase increment.
+     * @param wave The waveform index (0 = Sine, 1 = Saw, 2 = Square).
+     * @param phaseIncrement The oscillator frequency in cycles per sample (frequency / sampleRate).
+     * @return A pointer to the first of tableSize samples, readable from index -1 to tableSize + 1. Never null.
+     */
+    const float* getTable(int wave, float phaseIncrement) const noexcept;
+
+    /** @brief Reads a table at a normalised phase [0, 1) with linear interpolation. */
+    static float lookup(const float* table, float phase) noexcept
+    {
+        const auto position = phase * static_cast<float>(tableSize);
+        const auto index = static_cast<int>(position);
+        const auto fraction = position - static_cast<float>(index);
+        return table[index] + fraction * (table[index + 1] - table[index]);
+    }
+
+    /** @brief Reads a table at a normalised phase [0, 1) with 4-point Hermite interpolation. Used for offline renders. */
+    static float lookupCubic(const float* table, float phase) noexcept
+    {
+        const auto position = phase * static_cast<float>(tableSize);
+        const auto index = static_cast<int>(position);
+        const auto fraction = position - static_cast<float>(index);
+
+        const auto y0 = table[index - 1], y1 = table[index], y2 = table[index + 1], y3 = table[index + 2];
+        const auto c1 = 0.5f * (y2 - y0);
+        const auto c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+        const auto c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+        return ((c3 * fraction + c2) * fraction + c1) * fraction + y1;
+    }
+
+private:
+    /** @brief Returns the write pointer for one table of one waveform. */
+    float* getTableData(int wave, int tableIndex) noexcept;
+
+    /// @brief All tables of all waveforms in one contiguous block.
+    std::vector<float> tables;
+
+    JUCE_DECLARE_NON_COPYABLE(WavetableBank)
+};
@@ -0,0 +1,263 @@
+#include "ConvolutionReverb.hpp"
+
+namespace
+{
+    /// @brief The sample rate the built-in responses are generated at. Convolution resamples them if needed.
+    constexpr double generatorSampleRate = 48000.0;
+
+    /// @brief The -60 dB decay time of each built-in response, in seconds.
+    constexpr std::array<float, ConvolutionReverb::numImpulseResponses> decayTimes { 1.6f, 0.7f, 2.4f, 3.6f };
+}
+
+ConvolutionReverb::ConvolutionReverb()
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    for (int i = 0; i < numImpulseResponses; ++i)
+    {
+        // Zero latency selects JUCE's uniform engine, partitioned by the block size given to prepare().
+        engines[(size_t) i] = std::make_unique<juce::dsp::Convolution>(juce::dsp::Convolution::Latency { 0 });
+        loadImpulseResponse(i, formats);
+    }
+}
+
+const char* ConvolutionReverb::getImpulseResponseName(int index) noexcept
+{
+    switch (index)
+    {
+        case spring:  return "Spring";
+        case cantina: return "Cantina";
+        case plate:   return "Plate";
+        case hall:    return "Hall";
+        default:      return "";
+    }
+}
+
+juce::File ConvolutionReverb::getImpulseResponseDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("CantinaComposer")
+        .getChildFile("ImpulseResponses");
+}
+
+void ConvolutionReverb::loadImpulseResponse(int index, juce::AudioFormatManager& formats)
+{
+    auto& engine = *engines[(size_t) index];
+    const auto file = getImpulseResponseDirectory().getChildFile(juce::String(getImpulseResponseName(index)) + ".wav");
+
+    // Every response is exactly maxImpulseSeconds long at its own sample rate: longer files are trimmed,
+    // shorter ones and the generated responses are padded with silence. After resampling, all engines
+    // have the same number of partitions, so the selected response does not change the cost.
+    auto queue = [&](juce::AudioBuffer<float>&& impulse, double impulseSampleRate)
+    {
+        // Only queues the response; resampling and partitioning happen on the loader thread.
+        engine.loadImpulseResponse(std::move(impulse), impulseSampleRate, juce::dsp::Convolution::Stereo::yes,
+                                   juce::dsp::Convolution::Trim::no, juce::dsp::Convolution::Normalise::yes);
+    };
+
+    if (file.existsAsFile())
+    {
+        if (std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor(file)); reader != nullptr && reader->sampleRate > 0)
+        {
+            const auto length = (int) (maxImpulseSeconds * reader->sampleRate);
+            const auto numToRead = (int) juce::jmin((juce::int64) length, reader->lengthInSamples);
+
+            juce::AudioBuffer<float> impulse ((int) juce::jlimit(1u, 2u, reader->numChannels), length);
+            impulse.clear();
+            reader->read(&impulse, 0, numToRead, 0, true, true);
+
+            queue(std::move(impulse), reader->sampleRate);
+            return;
+        }
+    }
+
+    queue(generateImpulseResponse(index, generatorSampleRate), generatorSampleRate);
+}
+
+juce::AudioBuffer<float> ConvolutionReverb::generateImpulseResponse(int index, double sampleRate)
+{
+    const auto decayTime = decayTimes[(size_t) index];
+    const auto length = (int) (juce::jmin((double) decayTime * 1.2, maxImpulseSeconds) * sampleRate);
+    // -60 dB after decayTime.
+    const auto decayPerSample = std::exp(-6.9078f / (decayTime * (float) sampleRate));
+
+    // Padded with silence to the full maxImpulseSeconds, like every other response.
+    juce::AudioBuffer<float> impulse(2, (int) (maxImpulseSeconds * sampleRate));
+    impulse.clear();
+
+    for (int channel = 0; channel < impulse.getNumChannels(); ++channel)
+    {
+        // A fixed seed per response and channel: the same rooms every time, but decorrelated left and right.
+        juce::Random random(1 + index * 2 + channel);
+        auto* data = impulse.getWritePointer(channel);
+        auto envelope = 1.0f;
+        auto lowPassState = 0.0f;
+
+        for (int i = 0; i < length; ++i)
+        {
+            auto sample = random.nextFloat() * 2.0f - 1.0f;
+
+            if (index == hall)
+            {
+                // Air absorbs the highs first: the tail gets darker as it decays.
+                const auto darkening = 0.2f + 0.75f * (float) i / (float) length;
+                lowPassState += (1.0f - darkening) * (sample - lowPassState);
+                sample = lowPassState;
+            }
+
+            data[i] = sample * envelope;
+            envelope *= decayPerSample;
+        }
+
+        if (index == spring)
+        {
+            // The metallic flutter of a spring tank: a feedback comb with a ~37ms round trip.
+            const auto delay = (int) (0.037 * sampleRate) + channel * 7;
+            for (int i = delay; i < length; ++i)
+                data[i] += 0.6f * data[i - delay];
+        }
+        else if (index == cantina)
+        {
+            // A few strong early reflections off the walls of a small, crowded room.
+            constexpr std::array<float, 4> tapTimes { 0.007f, 0.013f, 0.019f, 0.029f };
+            constexpr std::array<float, 4> tapGains { 0.9f, 0.7f, -0.6f, 0.45f };
+            for (size_t t = 0; t < tapTimes.size(); ++t)
+            {
+                const auto position = (int) (tapTimes[t] * (float) sampleRate) + channel * 3;
+                if (position < length)
+                    data[position] += tapGains[t];
+            }
+        }
+        else if (index == hall)
+        {
+            // Pre-delay: the first reflection of a large space arrives late.
+            const auto preDelay = juce::jmin(length, (int) (0.025 * sampleRate));
+            juce::FloatVectorOperations::clear(data, preDelay);
+        }
+    }
+
+    return impulse;
+}
+
+void ConvolutionReverb::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+
+    for (auto& engine : engines)
+        engine->prepare(spec);
+
+    dampingFilter.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
+    dampingFilter.prepare(spec);
+
+    wetBuffer.setSize((int) spec.numChannels, (int) spec.maximumBlockSize);
+    fadeBuffer.setSize((int) spec.numChannels, (int) spec.maximumBlockSize);
+    // Every response is at most maxImpulseSeconds long; one more block covers the partitioning.
+    tailLength = (int) (maxImpulseSeconds * sampleRate) + (int) spec.maximumBlockSize;
+
+    activeEngine = selectedEngine;
+    reset();
+}
+
+void ConvolutionReverb::reset() noexcept
+{
+    for (auto& engine : engines)
+        engine->reset();
+
+    ringingEngine = -1;
+    ringingSamples = 0;
+    dampingFilter.reset();
+}
+
+void ConvolutionReverb::setParameters(float roomSize, float damping, float newWidth) noexcept
+{
+    selectedEngine = juce::jlimit(0, numImpulseResponses - 1, (int) (roomSize * (float) numImpulseResponses));
+    width = newWidth;
+
+    // 20 kHz at no damping down to 2 kHz at full damping, evenly spaced in octaves.
+    const auto cutoff = juce::jmin(20000.0f * std::pow(0.1f, damping), (float) sampleRate * 0.49f);
+    if (! juce::exactlyEqual(cutoff, dampingFilter.getCutoffFrequency()))
+        dampingFilter.setCutoffFrequency(cutoff);
+}
+
+void ConvolutionReverb::process(juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto numSamples = juce::jmin(block.getNumSamples(), (size_t) wetBuffer.getNumSamples());
+    const auto numChannels = juce::jmin(block.getNumChannels(), (size_t) wetBuffer.getNumChannels());
+    auto dry = block.getSubsetChannelBlock(0, numChannels).getSubBlock(0, numSamples);
+
+    auto wet = juce::dsp::AudioBlock<float>(wetBuffer).getSubsetChannelBlock(0, numChannels).getSubBlock(0, numSamples);
+    wet.copyFrom(dry);
+
+    auto ringing = juce::dsp::AudioBlock<float>(fadeBuffer).getSubsetChannelBlock(0, numChannels).getSubBlock(0, numSamples);
+
+    if (selectedEngine != activeEngine)
+    {
+        // The response being left takes over the ring-out slot. An older tail that is still ringing
+        // there is cut, so no block runs more than two engines. If the new response is the one that
+        // was ringing, it simply gets its input back.
+        if (ringingEngine >= 0 && ringingEngine != selectedEngine)
+            engines[(size_t) ringingEngine]->reset();
+
+        // Hand the input over to the new response across this block. The old one is not cut:
+        // its input fades out here, and its tail keeps ringing in the slot for as long as it lasts.
+        ringing.copyFrom(dry);
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            auto* in = wet.getChannelPointer(channel);
+            auto* out = ringing.getChannelPointer(channel);
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                const auto gain = (float) (i + 1) / (float) numSamples;
+                in[i] *= gain;
+                out[i] *= 1.0f - gain;
+            }
+        }
+
+        engines[(size_t) activeEngine]->process(juce::dsp::ProcessContextReplacing<float>(ringing));
+        ringingEngine = activeEngine;
+        ringingSamples = tailLength;
+
+        activeEngine = selectedEngine;
+        engines[(size_t) activeEngine]->process(juce::dsp::ProcessContextReplacing<float>(wet));
+        wet.add(ringing);
+    }
+    else
+    {
+        engines[(size_t) activeEngine]->process(juce::dsp::ProcessContextReplacing<float>(wet));
+
+        // The response switched away from earlier rings out on silence.
+        if (ringingEngine >= 0)
+        {
+            ringing.clear();
+            engines[(size_t) ringingEngine]->process(juce::dsp::ProcessContextReplacing<float>(ringing));
+            wet.add(ringing);
+
+            ringingSamples -= (int) numSamples;
+            if (ringingSamples <= 0)
+                ringingEngine = -1;
+        }
+    }
+
+    dampingFilter.process(juce::dsp::ProcessContextReplacing<float>(wet));
+
+    // Width works on the wet signal in mid/side: 0 is mono, 1 is the full stereo response.
+    if (numChannels == 2)
+    {
+        auto* left = wet.getChannelPointer(0);
+        auto* right = wet.getChannelPointer(1);
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto mid = 0.5f * (left[i] + right[i]);
+            const auto side = 0.5f * (left[i] - right[i]) * width;
+            left[i] = mid + side;
+            right[i] = mid - side;
+        }
+    }
+
+    // Fully wet: the processor mixes the dry signal back in along the "Distance" ramp.
+    dry.copyFrom(wet);
+}
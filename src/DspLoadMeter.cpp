@@ -0,0 +1,102 @@
+#include "DspLoadMeter.hpp"
+
+void DspLoadMeter::prepare(double newSampleRate) noexcept
+{
+    sampleRate = newSampleRate;
+    ticksPerMicrosecond = (double) juce::Time::getHighResolutionTicksPerSecond() * 1.0e-6;
+    windowSamples = juce::jmax((juce::int64) 1, (juce::int64) (sampleRate * windowSeconds));
+
+    for (auto& accumulator : accumulators)
+        accumulator = {};
+
+    samplesInWindow = 0;
+    windowPeakLoad = 0.0f;
+}
+
+void DspLoadMeter::accumulate(int entry, juce::int64 elapsedTicks) noexcept
+{
+    auto& accumulator = accumulators[(size_t) entry];
+
+    accumulator.minTicks = accumulator.count == 0 ? elapsedTicks : juce::jmin(accumulator.minTicks, elapsedTicks);
+    accumulator.maxTicks = juce::jmax(accumulator.maxTicks, elapsedTicks);
+    accumulator.sumTicks += elapsedTicks;
+    ++accumulator.count;
+
+    const auto micros = juce::jmax(lowestBinMicros, (double) elapsedTicks / ticksPerMicrosecond);
+    const auto bin = (int) (std::log2(micros / lowestBinMicros) * binsPerOctave);
+    ++accumulator.histogram[(size_t) juce::jlimit(0, numBins - 1, bin)];
+}
+
+void DspLoadMeter::addBlock(int numSamples, juce::int64 elapsedTicks) noexcept
+{
+    accumulate(totalEntry, elapsedTicks);
+
+    const auto deadlineTicks = (double) numSamples / sampleRate * ticksPerMicrosecond * 1.0e6;
+    if (deadlineTicks > 0.0)
+        windowPeakLoad = juce::jmax(windowPeakLoad, (float) (100.0 * (double) elapsedTicks / deadlineTicks));
+
+    samplesInWindow += numSamples;
+    if (samplesInWindow >= windowSamples)
+        publish();
+}
+
+void DspLoadMeter::publish() noexcept
+{
+    const auto windowDeadlineTicks = (double) samplesInWindow / sampleRate * ticksPerMicrosecond * 1.0e6;
+
+    for (int entry = 0; entry < numEntries; ++entry)
+    {
+        auto& accumulator = accumulators[(size_t) entry];
+        auto& stats = published[(size_t) entry];
+
+        if (accumulator.count == 0)
+        {
+            // A stage that did not run at all (e.g. the effects while asleep) costs nothing.
+            stats.minMicros.store(0.0f, std::memory_order_relaxed);
+            stats.meanMicros.store(0.0f, std::memory_order_relaxed);
+            stats.p99Micros.store(0.0f, std::memory_order_relaxed);
+            stats.maxMicros.store(0.0f, std::memory_order_relaxed);
+            stats.loadPercent.store(0.0f, std::memory_order_relaxed);
+            continue;
+        }
+
+        // The 99th percentile is the upper edge of the bin where 99% of the runs are reached.
+        const auto target = (accumulator.count * 99 + 99) / 100;
+        juce::int64 seen = 0;
+        int bin = 0;
+        for (; bin < numBins - 1; ++bin)
+        {
+            seen += accumulator.histogram[(size_t) bin];
+            if (seen >= target)
+                break;
+        }
+
+        const auto binTop = lowestBinMicros * std::exp2((double) (bin + 1) / binsPerOctave);
+        const auto maxMicros = (double) accumulator.maxTicks / ticksPerMicrosecond;
+
+        stats.minMicros.store((float) ((double) accumulator.minTicks / ticksPerMicrosecond), std::memory_order_relaxed);
+        stats.meanMicros.store((float) ((double) accumulator.sumTicks / (double) accumulator.count / ticksPerMicrosecond), std::memory_order_relaxed);
+        stats.p99Micros.store((float) juce::jmin(binTop, maxMicros), std::memory_order_relaxed);
+        stats.maxMicros.store((float) maxMicros, std::memory_order_relaxed);
+        stats.loadPercent.store((float) (100.0 * (double) accumulator.sumTicks / windowDeadlineTicks), std::memory_order_relaxed);
+
+        accumulator = {};
+    }
+
+    peakLoadPercent.store(windowPeakLoad, std::memory_order_relaxed);
+    windowPeakLoad = 0.0f;
+    samplesInWindow = 0;
+}
+
+DspLoadMeter::Stats DspLoadMeter::getStats(int entry) const noexcept
+{
+    const auto& stats = published[(size_t) entry];
+
+    Stats result;
+    result.minMicros = stats.minMicros.load(std::memory_order_relaxed);
+    result.meanMicros = stats.meanMicros.load(std::memory_order_relaxed);
+    result.p99Micros = stats.p99Micros.load(std::memory_order_relaxed);
+    result.maxMicros = stats.maxMicros.load(std::memory_order_relaxed);
+    result.loadPercent = stats.loadPercent.load(std::memory_order_relaxed);
+    return result;
+}
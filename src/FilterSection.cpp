@@ -0,0 +1,76 @@
+#include "FilterSection.hpp"
+
+namespace
+{
+    constexpr float shelfFrequency = 150.0f;
+    constexpr float shelfQ = 1.0f;
+}
+
+void FilterSection::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+
+    lowPass.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
+    lowPass.setResonance(1.0f / juce::MathConstants<float>::sqrt2);
+    lowPass.prepare(spec);
+
+    // The only allocation of the shelf: later updates overwrite these coefficients in place.
+    lowShelf.state = juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, shelfFrequency, shelfQ,
+                                                                        juce::Decibels::decibelsToGain(bassGain));
+    lowShelf.prepare(spec);
+
+    reset();
+}
+
+void FilterSection::reset() noexcept
+{
+    lowPass.reset();
+    lowShelf.reset();
+}
+
+void FilterSection::setBassGain(float newGainDecibels) noexcept
+{
+    if (juce::exactlyEqual(newGainDecibels, bassGain))
+        return;
+
+    bassGain = newGainDecibels;
+
+    // ArrayCoefficients returns a plain std::array, which is copied into the existing object.
+    *lowShelf.state = juce::dsp::IIR::ArrayCoefficients<float>::makeLowShelf(sampleRate, shelfFrequency, shelfQ,
+                                                                             juce::Decibels::decibelsToGain(bassGain));
+}
+
+void FilterSection::applyCutoff(float cutoffHz) noexcept
+{
+    const auto cutoff = juce::jlimit(20.0f, (float) sampleRate * 0.49f, cutoffHz);
+    if (! juce::exactlyEqual(cutoff, lowPass.getCutoffFrequency()))
+        lowPass.setCutoffFrequency(cutoff);
+}
+
+void FilterSection::process(juce::dsp::AudioBlock<float>& block, ParameterRamps::Ramp cutoff, ParameterRamps::Ramp gain) noexcept
+{
+    const auto numSamples = (int) block.getNumSamples();
+
+    if (! cutoff.isSmoothing() && ! gain.isSmoothing())
+    {
+        // Both calls return right away unless a ramp has just ended on a new value.
+        applyCutoff(cutoff.value);
+        setBassGain(gain.value);
+
+        lowPass.process(juce::dsp::ProcessContextReplacing<float>(block));
+        lowShelf.process(juce::dsp::ProcessContextReplacing<float>(block));
+        return;
+    }
+
+    // Step the filters along the ramps once per micro-block.
+    for (int start = 0; start < numSamples; start += ParameterRamps::microBlockSize)
+    {
+        const auto length = juce::jmin(ParameterRamps::microBlockSize, numSamples - start);
+        applyCutoff(cutoff[start + length - 1]);
+        setBassGain(gain[start + length - 1]);
+
+        auto subBlock = block.getSubBlock((size_t) start, (size_t) length);
+        lowPass.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+        lowShelf.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+    }
+}
@@ -0,0 +1,79 @@
+#include "JizzGobbler.hpp"
+
+void JizzGobbler::setAmount(float newAmount) noexcept
+{
+    if (juce::exactlyEqual(newAmount, amount))
+        return;
+
+    amount = newAmount;
+
+    // Map the 0-1 slider to our effect parameters
+    const auto bitDepth = juce::jmap(amount, 0.0f, 1.0f, 16.0f, 4.0f); // From 16-bit down to 4-bit
+    drive = juce::jmap(amount, 0.0f, 1.0f, 1.0f, 5.0f);                 // From 1x to 5x gain
+
+    const auto numBitLevels = std::pow(2.0f, bitDepth);
+    halfLevels = numBitLevels * 0.5f;
+    levelStep = 2.0f / numBitLevels;
+}
+
+JizzGobbler::Vec JizzGobbler::fastTanh(Vec x) noexcept
+{
+    x = Vec::min(Vec::max(x, Vec::expand(-5.0f)), Vec::expand(5.0f));
+    const auto x2 = x * x;
+    const auto numerator = x * (Vec::expand(135135.0f) + x2 * (Vec::expand(17325.0f) + x2 * (Vec::expand(378.0f) + x2)));
+    const auto denominator = Vec::expand(135135.0f) + x2 * (Vec::expand(62370.0f) + x2 * (Vec::expand(3150.0f) + x2 * Vec::expand(28.0f)));
+
+    // SIMDRegister has no division; a loop over one register's lanes compiles to a single vector divide.
+    alignas(64) float laneNumerator[Vec::size()];
+    alignas(64) float laneDenominator[Vec::size()];
+    numerator.copyToRawArray(laneNumerator);
+    denominator.copyToRawArray(laneDenominator);
+
+    for (size_t l = 0; l < Vec::size(); ++l)
+        laneNumerator[l] /= laneDenominator[l];
+
+    return Vec::min(Vec::max(Vec::fromRawArray(laneNumerator), Vec::expand(-1.0f)), Vec::expand(1.0f));
+}
+
+JizzGobbler::Vec JizzGobbler::quantize(Vec x) noexcept
+{
+    const auto offset = Vec::expand(roundingOffset);
+    const auto rounded = (x + offset) - offset;
+    // Where rounding went up, step back down by one.
+    return rounded - (Vec::expand(1.0f) & Vec::greaterThan(rounded, x));
+}
+
+void JizzGobbler::process(float* samples, int numSamples) const noexcept
+{
+    if (! isActive())
+        return;
+
+    // Scalar head up to the first aligned sample, then whole registers, then a scalar tail.
+    auto* const aligned = juce::jmin(Vec::getNextSIMDAlignedPtr(samples), samples + numSamples);
+    const auto numHead = (int) (aligned - samples);
+    const auto numVector = (numSamples - numHead) / (int) Vec::size() * (int) Vec::size();
+
+    for (int i = 0; i < numHead; ++i)
+        samples[i] = processSample(samples[i]);
+
+    const auto vDrive = Vec::expand(drive);
+    const auto vHalfLevels = Vec::expand(halfLevels);
+    const auto vLevelStep = Vec::expand(levelStep);
+    const auto one = Vec::expand(1.0f);
+
+    for (int i = numHead; i < numHead + numVector; i += (int) Vec::size())
+    {
+        const auto shaped = fastTanh(Vec::fromRawArray(samples + i) * vDrive);
+        const auto crushed = quantize(shaped * vHalfLevels + vHalfLevels) * vLevelStep - one;
+        crushed.copyToRawArray(samples + i);
+    }
+
+    for (int i = numHead + numVector; i < numSamples; ++i)
+        samples[i] = processSample(samples[i]);
+}
+
+void JizzGobbler::process(juce::dsp::AudioBlock<float>& block) const noexcept
+{
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        process(block.getChannelPointer(channel), (int) block.getNumSamples());
+}
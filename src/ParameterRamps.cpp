@@ -0,0 +1,77 @@
+#include "ParameterRamps.hpp"
+
+void LinearRamp::setTarget(float newTarget, int rampLength) noexcept
+{
+    if (juce::exactlyEqual(newTarget, target))
+        return;
+
+    target = newTarget;
+    remaining = rampLength;
+    step = (target - current) / (float) rampLength;
+}
+
+void LinearRamp::fill(float* destination, int numSamples) noexcept
+{
+    const auto numRamped = juce::jmin(numSamples, remaining);
+
+    // Every value is computed from the start of the chunk, not from the one before,
+    // so the loop has no dependency between samples and vectorises.
+    for (int s = 0; s < numRamped; ++s)
+        destination[s] = current + step * (float) (s + 1);
+
+    if (numRamped > 0)
+    {
+        remaining -= numRamped;
+        current = remaining == 0 ? target : current + step * (float) numRamped;
+    }
+
+    juce::FloatVectorOperations::fill(destination + numRamped, current, numSamples - numRamped);
+}
+
+void ParameterRamps::prepare(double sampleRate, int newMaximumBlockSize)
+{
+    maximumBlockSize = juce::jmax(1, newMaximumBlockSize);
+    buffers.assign((size_t) (maximumBlockSize * numParameters), 0.0f);
+    smoothing.fill(false);
+
+    // Approx. 50ms, like the filter smoother always had.
+    rampLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.05));
+}
+
+void ParameterRamps::setTargets(const ParameterSnapshot& snapshot) noexcept
+{
+    ramps[(size_t) reverbRoomSize].setTarget(snapshot.reverbRoomSize, rampLength);
+    ramps[(size_t) reverbWetLevel].setTarget(snapshot.reverbWetLevel, rampLength);
+    ramps[(size_t) reverbDamping].setTarget(snapshot.reverbDamping, rampLength);
+    ramps[(size_t) reverbWidth].setTarget(snapshot.reverbWidth, rampLength);
+    ramps[(size_t) gobblerAmount].setTarget(snapshot.gobblerAmount, rampLength);
+    ramps[(size_t) outputGain].setTarget(juce::Decibels::decibelsToGain(snapshot.outputLevel), rampLength);
+
+    for (int layer = 0; layer < InstrumentLayers::maxLayers; ++layer)
+    {
+        const auto& params = snapshot.layers[(size_t) layer];
+        ramps[(size_t) (filterFreq + layer)].setTarget(params.filterFreq, rampLength);
+        ramps[(size_t) (bassGain + layer)].setTarget(params.bassGain, rampLength);
+    }
+}
+
+void ParameterRamps::reset() noexcept
+{
+    for (auto& ramp : ramps)
+        ramp.skip();
+
+    smoothing.fill(false);
+}
+
+void ParameterRamps::fill(int numSamples) noexcept
+{
+    numSamples = juce::jmin(numSamples, maximumBlockSize);
+
+    for (size_t p = 0; p < ramps.size(); ++p)
+    {
+        // Parameters at rest write nothing: their single value is all a stage needs.
+        smoothing[p] = ramps[p].isSmoothing();
+        if (smoothing[p])
+            ramps[p].fill(buffers.data() + p * (size_t) maximumBlockSize, numSamples);
+    }
+}
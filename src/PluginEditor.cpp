@@ -14,6 +14,16 @@ CantinaComposerAudioProcessorEditor::CantinaComposerAudioProcessorEditor(Cantina
     titleLabel.setFont(juce::Font(24.0f, juce::Font::bold));
     titleLabel.setJustificationType(juce::Justification::centred);
 
+    // --- Multi-Timbral Layers ---
+    addAndMakeVisible(multiTimbralButton);
+    multiTimbralAttachment = std::make_unique<APVTS::ButtonAttachment>(audioProcessor.apvts, "MULTITIMBRAL", multiTimbralButton);
+    addAndMakeVisible(layerMenu);
+    layerMenu.setJustificationType(juce::Justification::centred);
+    for (int layer = 0; layer < InstrumentLayers::maxLayers; ++layer)
+        layerMenu.addItem("Layer " + juce::String(layer + 1) + " (Ch " + juce::String(layer + 1) + ")", layer + 1);
+    layerMenu.setSelectedId(1, juce::dontSendNotification);
+    layerMenu.addListener(this);
+
     // --- Waveform Visualizers ---
     staticWaveformVisualizer = std::make_unique<StaticWaveformVisualizer>(audioProcessor.apvts);
     addAndMakeVisible(staticWaveformVisualizer.get());
@@ -32,6 +42,9 @@ CantinaComposerAudioProcessorEditor::CantinaComposerAudioProcessorEditor(Cantina
     presetAttachment = std::make_unique<ComboBoxAttachment>(audioProcessor.apvts, "PRESET", presetMenu);
     presetMenu.addListener(this); // We listen manually to trigger preset loading.
 
+    addAndMakeVisible(libraryButton);
+    libraryButton.onClick = [this] { showLibraryMenu(); };
+
     addAndMakeVisible(waveMenu);
     waveMenu.setJustificationType(juce::Justification::centred);
     if (auto *param = dynamic_cast<juce::AudioParameterChoice *>(audioProcessor.apvts.getParameter("WAVE")))
@@ -78,6 +91,17 @@ CantinaComposerAudioProcessorEditor::CantinaComposerAudioProcessorEditor(Cantina
     setupHorizontalSlider(freqSlider, freqLabel, "Frequency", "FILTER_FREQ", freqAttachment);
     setupHorizontalSlider(bassSlider, bassLabel, "Bass", "BASS_GAIN", bassAttachment);
     setupHorizontalSlider(blasterSlider, blasterLabel, "Blaster", "PITCH", blasterAttachment);
+    setupHorizontalSlider(unisonSlider, unisonLabel, "Unison", "UNISON", unisonAttachment);
+    setupHorizontalSlider(detuneSlider, detuneLabel, "Detune", "UNISON_DETUNE", detuneAttachment);
+
+    addAndMakeVisible(voiceFilterLabel);
+    voiceFilterLabel.setText("Voice Filter", juce::dontSendNotification);
+    voiceFilterLabel.setJustificationType(juce::Justification::centred);
+    setupRotarySlider(voiceCutoffSlider, voiceCutoffLabel, "Cutoff", "VOICE_CUTOFF", voiceCutoffAttachment);
+    setupRotarySlider(voiceResonanceSlider, voiceResonanceLabel, "Resonance", "VOICE_RESONANCE", voiceResonanceAttachment);
+    setupRotarySlider(voiceEnvAmountSlider, voiceEnvAmountLabel, "Env Amount", "VOICE_ENV_AMOUNT", voiceEnvAmountAttachment);
+    setupRotarySlider(voiceEnvDecaySlider, voiceEnvDecayLabel, "Env Decay", "VOICE_ENV_DECAY", voiceEnvDecayAttachment);
+    setupRotarySlider(voiceKeytrackSlider, voiceKeytrackLabel, "Keytrack", "VOICE_KEYTRACK", voiceKeytrackAttachment);
 
     addAndMakeVisible(spaceWobblerLabel);
     spaceWobblerLabel.setText("Space Wobbler", juce::dontSendNotification);
@@ -87,6 +111,16 @@ CantinaComposerAudioProcessorEditor::CantinaComposerAudioProcessorEditor(Cantina
     setupRotarySlider(dampingSlider, dampingLabel, "Damping", "REVERB_DAMPING", dampingAttachment);
     setupRotarySlider(widthSlider, widthLabel, "Width", "REVERB_WIDTH", widthAttachment);
 
+    addAndMakeVisible(wobblerModeMenu);
+    wobblerModeMenu.setJustificationType(juce::Justification::centred);
+    if (auto *param = dynamic_cast<juce::AudioParameterChoice *>(audioProcessor.apvts.getParameter("REVERB_MODE")))
+    {
+        int id = 1;
+        for (const auto &choice : param->choices)
+            wobblerModeMenu.addItem(choice, id++);
+    }
+    wobblerModeAttachment = std::make_unique<ComboBoxAttachment>(audioProcessor.apvts, "REVERB_MODE", wobblerModeMenu);
+
     addAndMakeVisible(jizzGobblerSlider);
     jizzGobblerSlider.setSliderStyle(juce::Slider::LinearHorizontal);
     jizzGobblerSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 80, 20);
@@ -94,14 +128,21 @@ CantinaComposerAudioProcessorEditor::CantinaComposerAudioProcessorEditor(Cantina
     addAndMakeVisible(jizzGobblerLabel);
     jizzGobblerLabel.setText("Jizz Gobbler", juce::dontSendNotification);
     jizzGobblerLabel.setJustificationType(juce::Justification::centred);
+    setupHorizontalSlider(outputLevelSlider, outputLevelLabel, "Level", "OUTPUT_LEVEL", outputLevelAttachment);
+
+    // --- DSP Load Overlay ---
+    // Added last, so it is drawn on top of everything else.
+    loadMeterOverlay = std::make_unique<LoadMeterOverlay>(audioProcessor.getLoadMeter());
+    addAndMakeVisible(loadMeterOverlay.get());
 
     // Initial size of the plugin window.
-    setSize(800, 760);
+    setSize(800, 860);
 }
 
 CantinaComposerAudioProcessorEditor::~CantinaComposerAudioProcessorEditor()
 {
     presetMenu.removeListener(this);
+    layerMenu.removeListener(this);
     setLookAndFeel(nullptr);
 }
 
@@ -118,9 +159,139 @@ void CantinaComposerAudioProcessorEditor::comboBoxChanged(juce::ComboBox* comboB
         const int presetIndex = presetMenu.getSelectedId() - 1; // Convert 1-based ID to 0-based index. Why JUCE, why?
         if (presetIndex >= 0)
         {
-            audioProcessor.setPreset(presetIndex);
+            audioProcessor.setPreset(presetIndex, selectedLayer);
         }
     }
+    else if (comboBoxThatHasChanged == &layerMenu)
+    {
+        selectLayer(layerMenu.getSelectedId() - 1);
+    }
+}
+
+void CantinaComposerAudioProcessorEditor::selectLayer(int layer)
+{
+    if (layer < 0 || layer == selectedLayer)
+        return;
+
+    selectedLayer = layer;
+    auto& apvts = audioProcessor.apvts;
+    auto id = [layer](const char* mainID) { return InstrumentLayers::getParameterID(mainID, layer); };
+
+    // The new attachment shows the layer's current preset. That is not a request to load it again.
+    presetMenu.removeListener(this);
+
+    // An attachment can only be replaced once the old one has let go of the control.
+    presetAttachment.reset();
+    waveAttachment.reset();
+    attackAttachment.reset();
+    decayAttachment.reset();
+    sustainAttachment.reset();
+    releaseAttachment.reset();
+    freqAttachment.reset();
+    bassAttachment.reset();
+    unisonAttachment.reset();
+    detuneAttachment.reset();
+    voiceCutoffAttachment.reset();
+    voiceResonanceAttachment.reset();
+    voiceEnvAmountAttachment.reset();
+    voiceEnvDecayAttachment.reset();
+    voiceKeytrackAttachment.reset();
+
+    presetAttachment = std::make_unique<ComboBoxAttachment>(apvts, id("PRESET"), presetMenu);
+    waveAttachment = std::make_unique<ComboBoxAttachment>(apvts, id("WAVE"), waveMenu);
+    attackAttachment = std::make_unique<SliderAttachment>(apvts, id("ATTACK"), attackSlider);
+    decayAttachment = std::make_unique<SliderAttachment>(apvts, id("DECAY"), decaySlider);
+    sustainAttachment = std::make_unique<SliderAttachment>(apvts, id("SUSTAIN"), sustainSlider);
+    releaseAttachment = std::make_unique<SliderAttachment>(apvts, id("RELEASE"), releaseSlider);
+    freqAttachment = std::make_unique<SliderAttachment>(apvts, id("FILTER_FREQ"), freqSlider);
+    bassAttachment = std::make_unique<SliderAttachment>(apvts, id("BASS_GAIN"), bassSlider);
+    unisonAttachment = std::make_unique<SliderAttachment>(apvts, id("UNISON"), unisonSlider);
+    detuneAttachment = std::make_unique<SliderAttachment>(apvts, id("UNISON_DETUNE"), detuneSlider);
+    voiceCutoffAttachment = std::make_unique<SliderAttachment>(apvts, id("VOICE_CUTOFF"), voiceCutoffSlider);
+    voiceResonanceAttachment = std::make_unique<SliderAttachment>(apvts, id("VOICE_RESONANCE"), voiceResonanceSlider);
+    voiceEnvAmountAttachment = std::make_unique<SliderAttachment>(apvts, id("VOICE_ENV_AMOUNT"), voiceEnvAmountSlider);
+    voiceEnvDecayAttachment = std::make_unique<SliderAttachment>(apvts, id("VOICE_ENV_DECAY"), voiceEnvDecaySlider);
+    voiceKeytrackAttachment = std::make_unique<SliderAttachment>(apvts, id("VOICE_KEYTRACK"), voiceKeytrackSlider);
+
+    presetMenu.addListener(this);
+    staticWaveformVisualizer->setLayer(layer);
+}
+
+void CantinaComposerAudioProcessorEditor::showLibraryMenu()
+{
+    const auto& library = audioProcessor.getPresetLibrary();
+
+    // Copies, not views: the views point into the user bank, which may be closed while the menu is open.
+    std::vector<std::string> categories;
+    juce::PopupMenu menu;
+    int id = 1;
+    for (auto category : library.getCategories())
+    {
+        const auto count = library.getPresetsInCategory(category).size();
+        menu.addItem(id++, juce::String::fromUTF8(category.data(), (int) category.size()) + " (" + juce::String(count) + ")");
+        categories.emplace_back(category);
+    }
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&libraryButton),
+                       [editor = juce::Component::SafePointer(this), names = std::move(categories)](int result)
+                       {
+                           if (editor != nullptr && result > 0)
+                               editor->showCategoryMenu(names[(size_t) result - 1]);
+                       });
+}
+
+void CantinaComposerAudioProcessorEditor::showCategoryMenu(const std::string& category)
+{
+    const auto& presets = audioProcessor.getPresetLibrary().getPresetsInCategory(category);
+    const auto numPresets = (int) presets.size();
+    if (numPresets <= maxMenuItems)
+    {
+        showPresetMenu(presets, 0, numPresets);
+        return;
+    }
+
+    // Large categories first get a menu of pages, named after their first and last preset.
+    juce::PopupMenu menu;
+    for (int start = 0, id = 1; start < numPresets; start += maxMenuItems)
+    {
+        const auto end = juce::jmin(start + maxMenuItems, numPresets);
+        menu.addItem(id++, getPresetName(presets[(size_t) start]) + " - " + getPresetName(presets[(size_t) end - 1]));
+    }
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&libraryButton),
+                       [editor = juce::Component::SafePointer(this), category](int result)
+                       {
+                           if (editor == nullptr || result <= 0)
+                               return;
+
+                           // The index may have been rebuilt since this menu opened: look the category up again.
+                           const auto& currentPresets = editor->audioProcessor.getPresetLibrary().getPresetsInCategory(category);
+                           const auto start = (result - 1) * maxMenuItems;
+                           const auto end = juce::jmin(start + maxMenuItems, (int) currentPresets.size());
+                           if (start < end)
+                               editor->showPresetMenu(currentPresets, start, end);
+                       });
+}
+
+void CantinaComposerAudioProcessorEditor::showPresetMenu(const std::vector<int>& presets, int start, int end)
+{
+    // Item IDs are the library index + 1, so the result needs no lookup.
+    juce::PopupMenu menu;
+    for (int i = start; i < end; ++i)
+        menu.addItem(presets[(size_t) i] + 1, getPresetName(presets[(size_t) i]));
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&libraryButton),
+                       [editor = juce::Component::SafePointer(this)](int result)
+                       {
+                           if (editor != nullptr && result > 0)
+                               editor->audioProcessor.getPresetLibrary().applyPreset(result - 1, editor->selectedLayer);
+                       });
+}
+
+juce::String CantinaComposerAudioProcessorEditor::getPresetName(int index) const
+{
+    const auto name = audioProcessor.getPresetLibrary().getName(index);
+    return juce::String::fromUTF8(name.data(), (int) name.size());
 }
 
 void CantinaComposerAudioProcessorEditor::resized()
@@ -128,12 +299,22 @@ void CantinaComposerAudioProcessorEditor::resized()
     // Get the entire area of the editor window.
     auto bounds = getLocalBounds();
 
-    // Top section for the title.
-    titleLabel.setBounds(bounds.removeFromTop(40).reduced(5));
+    // The load overlay floats over the top right corner and grows downwards when expanded.
+    loadMeterOverlay->setBounds(bounds.getRight() - 250, 6, 244, loadMeterOverlay->getPreferredHeight());
+
+    // Top section for the title, with the layer controls on its left.
+    auto titleArea = bounds.removeFromTop(40);
+    auto layerArea = titleArea.removeFromLeft(270).reduced(5);
+    multiTimbralButton.setBounds(layerArea.removeFromLeft(120));
+    layerMenu.setBounds(layerArea);
+    titleArea.removeFromRight(270); // Keeps the title centred.
+    titleLabel.setBounds(titleArea.reduced(5));
 
     // Second section for the preset and waveform menus.
     auto topArea = bounds.removeFromTop(50);
-    presetMenu.setBounds(topArea.removeFromLeft(topArea.getWidth() / 2).reduced(10));
+    auto presetArea = topArea.removeFromLeft(topArea.getWidth() / 2);
+    libraryButton.setBounds(presetArea.removeFromRight(90).reduced(0, 10).withTrimmedRight(10));
+    presetMenu.setBounds(presetArea.reduced(10));
     waveMenu.setBounds(topArea.reduced(10));
 
     // Main content area with synth controls.
@@ -163,21 +344,43 @@ void CantinaComposerAudioProcessorEditor::resized()
     auto freqArea = rightColumn.removeFromTop(horizontalSliderHeight);
     freqLabel.setBounds(freqArea.removeFromLeft(labelWidth));
     freqSlider.setBounds(freqArea);
+    auto unisonArea = rightColumn.removeFromTop(horizontalSliderHeight);
+    auto detuneArea = unisonArea.removeFromRight(unisonArea.getWidth() / 2);
+    unisonLabel.setBounds(unisonArea.removeFromLeft(labelWidth));
+    unisonSlider.setBounds(unisonArea);
+    detuneLabel.setBounds(detuneArea.removeFromLeft(labelWidth));
+    detuneSlider.setBounds(detuneArea);
+
+    // The "Voice Filter" row below the envelope and tone controls.
+    auto voiceFilterArea = bounds.removeFromTop(100);
+    voiceFilterLabel.setBounds(voiceFilterArea.removeFromTop(30));
+    auto voiceFilterSliderWidth = voiceFilterArea.getWidth() / 5;
+    voiceCutoffSlider.setBounds(voiceFilterArea.removeFromLeft(voiceFilterSliderWidth).reduced(15));
+    voiceResonanceSlider.setBounds(voiceFilterArea.removeFromLeft(voiceFilterSliderWidth).reduced(15));
+    voiceEnvAmountSlider.setBounds(voiceFilterArea.removeFromLeft(voiceFilterSliderWidth).reduced(15));
+    voiceEnvDecaySlider.setBounds(voiceFilterArea.removeFromLeft(voiceFilterSliderWidth).reduced(15));
+    voiceKeytrackSlider.setBounds(voiceFilterArea.removeFromLeft(voiceFilterSliderWidth).reduced(15));
 
     // Effects section below the main controls.
     auto effectsArea = bounds.removeFromTop(180);
     
     // "Space Wobbler" takes the top part of the effects area.
     auto wobblerArea = effectsArea.removeFromTop(100);
-    spaceWobblerLabel.setBounds(wobblerArea.removeFromTop(30));
+    auto wobblerHeader = wobblerArea.removeFromTop(30);
+    wobblerModeMenu.setBounds(wobblerHeader.removeFromRight(140).reduced(4, 2));
+    wobblerHeader.removeFromLeft(140); // Keeps the section title centred.
+    spaceWobblerLabel.setBounds(wobblerHeader);
     auto effectSliderWidth = wobblerArea.getWidth() / 4;
     chamberSlider.setBounds(wobblerArea.removeFromLeft(effectSliderWidth).reduced(15));
     distanceSlider.setBounds(wobblerArea.removeFromLeft(effectSliderWidth).reduced(15));
     dampingSlider.setBounds(wobblerArea.removeFromLeft(effectSliderWidth).reduced(15));
     widthSlider.setBounds(wobblerArea.removeFromLeft(effectSliderWidth).reduced(15));
 
-    // "Jizz Gobbler" takes the remaining part of the effects area.
+    // "Jizz Gobbler" takes the remaining part of the effects area, next to the output level.
     auto gobblerArea = effectsArea;
+    auto levelArea = gobblerArea.removeFromRight(gobblerArea.getWidth() / 3);
+    outputLevelLabel.setBounds(levelArea.removeFromTop(30));
+    outputLevelSlider.setBounds(levelArea.reduced(20, 0));
     jizzGobblerLabel.setBounds(gobblerArea.removeFromTop(30));
     jizzGobblerSlider.setBounds(gobblerArea.reduced(20, 0));
 
@@ -5,13 +5,27 @@ CantinaComposerAudioProcessor::CantinaComposerAudioProcessor()
     : AudioProcessor (BusesProperties().withOutput ("Output", juce::AudioChannelSet::stereo(), true)),
       apvts (*this, nullptr, "Parameters", createParameterLayout())
 {
-    synth.addSound(new SynthSound());
-    for (int i = 0; i < 8; ++i)
-        synth.addVoice(new SynthVoice(apvts));
+    voiceBank.setRenderPool(&renderPool);
+
+    // The user bank is only mapped here; its presets are read when one is loaded.
+    if (const auto bankFile = PresetLibrary::getDefaultBankFile(); bankFile.existsAsFile())
+        presetLibrary.openBank(bankFile);
+
+    // A fresh instance starts with the selected preset of every layer. This happens once, here: hosts
+    // restore their state before preparing and prepare again at will, and neither may undo the user's edits.
+    // Afterwards, a preset is only applied when one is picked.
+    for (int layer = 0; layer < InstrumentLayers::maxLayers; ++layer)
+        setPreset(static_cast<int>(apvts.getRawParameterValue(InstrumentLayers::getParameterID("PRESET", layer))->load()), layer);
+
+    apvts.addParameterListener("MULTICORE", this);
+    apvts.addParameterListener("OVERSAMPLING", this);
 }
 
 CantinaComposerAudioProcessor::~CantinaComposerAudioProcessor()
 {
+    apvts.removeParameterListener("MULTICORE", this);
+    apvts.removeParameterListener("OVERSAMPLING", this);
+    cancelPendingUpdate();
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout CantinaComposerAudioProcessor::createParameterLayout()
@@ -19,211 +33,528 @@ juce::AudioProcessorValueTreeState::ParameterLayout CantinaComposerAudioProcesso
     std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
     // Available waves
     juce::StringArray waveChoices = { "Sine", "Saw", "Square" };
-    // Available presets
-    juce::StringArray presetChoices = { "Kloo Horn (Flute)", "Fanfar (Steel Drum)", "Gasan String-drum", "Ommni Box (Clarinet)" };
+    // Available presets: the factory presets of the library
+    juce::StringArray presetChoices = PresetLibrary::getFactoryPresetNames();
+    // Available "Space Wobbler" engines
+    juce::StringArray reverbModeChoices = { "Classic", "Convolution" };
+    // Available oversampling factors for the distortion
+    juce::StringArray oversamplingChoices = { "Off", "2x", "4x", "8x" };
+
+    // Ranges shared by the main parameters and the copies of the other layers
+    const juce::NormalisableRange<float> envelopeTimeRange (0.01f, 1.0f, 0.001f, 0.3f);
+    const juce::NormalisableRange<float> sustainRange (0.0f, 1.0f, 0.01f);
+    const juce::NormalisableRange<float> releaseRange (0.01f, 3.0f, 0.001f, 0.3f);
+    const juce::NormalisableRange<float> filterFreqRange (20.0f, 20000.0f, 1.0f, 0.3f);
+    const juce::NormalisableRange<float> bassGainRange (-24.0f, 24.0f, 0.1f);
+    const juce::NormalisableRange<float> unisonDetuneRange (0.0f, 100.0f, 0.1f);
+    const juce::NormalisableRange<float> resonanceRange (0.5f, 10.0f, 0.01f, 0.4f);
+    const juce::NormalisableRange<float> envAmountRange (0.0f, 8.0f, 0.01f);
+    const juce::NormalisableRange<float> envDecayRange (0.005f, 4.0f, 0.001f, 0.3f);
+    const juce::NormalisableRange<float> keytrackRange (0.0f, 1.0f, 0.01f);
 
     // --- Main Synth Parameters ---
     params.push_back (std::make_unique<juce::AudioParameterChoice> ("PRESET", "Preset", presetChoices, 0));
     params.push_back (std::make_unique<juce::AudioParameterChoice> ("WAVE", "Waveform", waveChoices, 0));
     // --- Galactic Envelope (ADSR) ---
-    params.push_back (std::make_unique<juce::AudioParameterFloat> ("ATTACK", "Attack", juce::NormalisableRange<float>(0.01f, 1.0f, 0.001f, 0.3f), 0.1f));
-    params.push_back (std::make_unique<juce::AudioParameterFloat> ("DECAY", "Decay", juce::NormalisableRange<float>(0.01f, 1.0f, 0.001f, 0.3f), 0.2f));
-    params.push_back (std::make_unique<juce::AudioParameterFloat> ("SUSTAIN", "Sustain", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.8f));
-    params.push_back (std::make_unique<juce::AudioParameterFloat> ("RELEASE", "Release", juce::NormalisableRange<float>(0.01f, 3.0f, 0.001f, 0.3f), 0.4f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("ATTACK", "Attack", envelopeTimeRange, 0.1f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("DECAY", "Decay", envelopeTimeRange, 0.2f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("SUSTAIN", "Sustain", sustainRange, 0.8f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("RELEASE", "Release", releaseRange, 0.4f));
     // --- Filter & Tone Control ---
-    params.push_back (std::make_unique<juce::AudioParameterFloat> ("FILTER_FREQ", "Frequency", juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.3f), 20000.0f));
-    params.push_back (std::make_unique<juce::AudioParameterFloat> ("BASS_GAIN", "Bass", juce::NormalisableRange<float>(-24.0f, 24.0f, 0.1f), 0.0f)); 
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("FILTER_FREQ", "Frequency", filterFreqRange, 20000.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("BASS_GAIN", "Bass", bassGainRange, 0.0f)); 
     params.push_back(std::make_unique<juce::AudioParameterFloat>("PITCH", "Pitch", juce::NormalisableRange<float>(-12.0f, 12.0f, 0.1f), 0.0f));
     // --- Space Wobbler (Reverb) Parameters ---
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("REVERB_MODE", "Space Wobbler Mode", reverbModeChoices, 0));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("REVERB_ROOM_SIZE", "Chamber Size", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("REVERB_WET_LEVEL", "Distance", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.33f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("REVERB_DAMPING", "Damping", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("REVERB_WIDTH", "Width", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 1.0f));
+    // --- Engine ---
+    params.push_back(std::make_unique<juce::AudioParameterInt>("POLYPHONY", "Voices", 1, VoiceDispatcher::maxVoices, 8));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("MULTICORE", "Multi-Core Voices", false, juce::AudioParameterBoolAttributes().withAutomatable(false)));
     // --- Jizz Gobbler (Distortion) Parameter ---
     params.push_back(std::make_unique<juce::AudioParameterFloat>("JIZZ_GOBBLER_AMOUNT", "Intensity", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("OVERSAMPLING", "Oversampling", oversamplingChoices, 0, juce::AudioParameterChoiceAttributes().withAutomatable(false)));
+    // --- Output ---
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("OUTPUT_LEVEL", "Level", juce::NormalisableRange<float>(-48.0f, 6.0f, 0.1f), 0.0f));
+
+    // --- Unison ---
+    params.push_back(std::make_unique<juce::AudioParameterInt>("UNISON", "Unison", 1, VoiceBank::maxUnison, 1));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("UNISON_DETUNE", "Detune", unisonDetuneRange, 20.0f));
+
+    // --- Voice Filter ---
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("VOICE_CUTOFF", "Voice Cutoff", filterFreqRange, 20000.0f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("VOICE_RESONANCE", "Voice Resonance", resonanceRange, 0.707f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("VOICE_ENV_AMOUNT", "Filter Env", envAmountRange, 0.0f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("VOICE_ENV_DECAY", "Filter Decay", envDecayRange, 0.3f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("VOICE_KEYTRACK", "Keytrack", keytrackRange, 0.0f));
+
+    // --- Multi-Timbral Layers ---
+    // Layer 1 plays from the main parameters above; layers 2-4 (MIDI channels 2-4) get their own copies.
+    // Each layer starts out with the next factory instrument, so switching on gives the whole band.
+    params.push_back(std::make_unique<juce::AudioParameterBool>("MULTITIMBRAL", "Multi-Timbral", false, juce::AudioParameterBoolAttributes().withAutomatable(false)));
+    for (int layer = 1; layer < InstrumentLayers::maxLayers; ++layer)
+    {
+        const auto id = [layer](const char* mainID) { return InstrumentLayers::getParameterID(mainID, layer); };
+        const auto name = "Layer " + juce::String(layer + 1) + " ";
+
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(id("PRESET"), name + "Preset", presetChoices, layer % presetChoices.size()));
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(id("WAVE"), name + "Waveform", waveChoices, 0));
+        params.push_back(std::make_unique<juce::AudioParameterInt>(id("POLYPHONY"), name + "Voices", 1, VoiceDispatcher::maxVoices / InstrumentLayers::maxLayers, 8));
+        params.push_back(std::make_unique<juce::AudioParameterInt>(id("UNISON"), name + "Unison", 1, VoiceBank::maxUnison, 1));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(id("UNISON_DETUNE"), name + "Detune", unisonDetuneRange, 20.0f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(id("ATTACK"), name + "Attack", envelopeTimeRange, 0.1f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(id("DECAY"), name + "Decay", envelopeTimeRange, 0.2f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(id("SUSTAIN"), name + "Sustain", sustainRange, 0.8f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(id("RELEASE"), name + "Release", releaseRange, 0.4f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(id("VOICE_CUTOFF"), name + "Voice Cutoff", filterFreqRange, 20000.0f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(id("VOICE_RESONANCE"), name + "Voice Resonance", resonanceRange, 0.707f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(id("VOICE_ENV_AMOUNT"), name + "Filter Env", envAmountRange, 0.0f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(id("VOICE_ENV_DECAY"), name + "Filter Decay", envDecayRange, 0.3f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(id("VOICE_KEYTRACK"), name + "Keytrack", keytrackRange, 0.0f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(id("FILTER_FREQ"), name + "Frequency", filterFreqRange, 20000.0f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(id("BASS_GAIN"), name + "Bass", bassGainRange, 0.0f));
+    }
+
     return { params.begin(), params.end() };
 }
 
 void CantinaComposerAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    // Inform the main synth engine about the host's sample rate.
-    synth.setCurrentPlaybackSampleRate(sampleRate);
-    
-    // Each synth voice must also be prepared individually.
-    for (int i = 0; i < synth.getNumVoices(); ++i)
-    {
-        if (auto voice = dynamic_cast<SynthVoice*>(synth.getVoice(i)))
-        {
-            voice->prepareToPlay(sampleRate, samplesPerBlock, getTotalNumOutputChannels());
-        }
-    }
+    // An offline render gets room for large blocks, the best interpolation and all cores.
+    const auto offline = isNonRealtime();
+    maximumBlockSize = juce::jmax(1, offline ? juce::jmax(samplesPerBlock, offlineMaximumBlockSize) : samplesPerBlock);
+    voiceBank.setHighQuality(offline);
+
+    // All voices live in the bank, which is prepared once for all of them.
+    voiceBank.prepare(sampleRate, maximumBlockSize);
+    // The bank has just silenced every slot, so forget all notes as well.
+    synth.reset();
+    updateRenderPool();
     
     // Create a "Process Specification" object. This acts as a contract, telling our
     // DSP modules (filters, reverb, etc.) about the audio environment they will run in.
     juce::dsp::ProcessSpec spec;
     spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
+    spec.maximumBlockSize = (juce::uint32) maximumBlockSize;
     spec.numChannels = getTotalNumOutputChannels();
 
     // Prepare our DSP chains with the specification.
-    filterChain.prepare(spec);
+    // The voices are mono, so every layer is filtered on its own mono bus before the layers are mixed.
+    auto layerSpec = spec;
+    layerSpec.numChannels = 1;
+    for (auto& filter : layerFilters)
+        filter.prepare(layerSpec);
+    layerBuses.setSize(InstrumentLayers::maxLayers, maximumBlockSize);
     reverb.prepare(spec);
+    convolutionReverb.prepare(spec);
+    dryBuffer.setSize((int) spec.numChannels, maximumBlockSize);
+    parameterRamps.prepare(sampleRate, maximumBlockSize);
 
-    // Reset the smoother for the filter frequency. This synchronizes it with the host's sample rate.
-    smoothedFilterFreq.reset(sampleRate, 0.05); // Approx. 50ms smoothing time, but can sometimes be off.
-    
-    // Set initial values for the filters.
-    updateFilters();
-
-    // When the plugin loads, apply the currently selected preset.
-    if (auto* presetParam = apvts.getRawParameterValue("PRESET"))
+    // Polyphase IIR half-band stages: the cheapest steep filters, and rounded to a whole-sample latency.
+    for (size_t i = 0; i < oversamplers.size(); ++i)
     {
-        setPreset(static_cast<int>(presetParam->load()));
+        oversamplers[i] = std::make_unique<juce::dsp::Oversampling<float>>(
+            spec.numChannels, i + 1, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true);
+        oversamplers[i]->initProcessing((size_t) maximumBlockSize);
     }
+
+    // Tell the visualizer history how to convert its samples back to time.
+    audioBufferQueue.prepare(sampleRate);
+    loadMeter.prepare(sampleRate);
+
+    // Set initial values for the effects, without gliding there from the old ones.
+    parameterHandles.load(currentParams);
+    parameterRamps.setTargets(currentParams);
+    parameterRamps.reset();
+    for (auto& filter : layerFilters)
+        filter.reset();
+
+    // Both reverb engines are fully wet; the dry signal is mixed back in per sample.
+    reverbParams.wetLevel = 1.0f;
+    reverbParams.dryLevel = 0.0f;
+    appliedRoomSize = appliedDamping = appliedWidth = -1.0f;
+    updateReverbSettings(currentParams.reverbRoomSize, currentParams.reverbDamping, currentParams.reverbWidth);
+
+    activeOversampling = getEffectiveOversampling(currentParams.oversampling);
+    activeReverbMode = currentParams.reverbMode;
+    updateLatency();
+
+    silenceHoldSamples = juce::roundToInt(sampleRate * silenceHoldSeconds);
+    silentSamples = 0;
+    effectsAsleep = false;
+}
+
+void CantinaComposerAudioProcessor::releaseResources()
+{
+    // Don't keep worker threads around while the host has us suspended.
+    renderPool.setNumWorkers(0);
+}
+
+void CantinaComposerAudioProcessor::parameterChanged(const juce::String& parameterID, float)
+{
+    // Starting threads and reporting latency are not realtime safe, and this may well be the audio thread.
+    if (parameterID == "MULTICORE" || parameterID == "OVERSAMPLING")
+        triggerAsyncUpdate();
+}
+
+void CantinaComposerAudioProcessor::setNonRealtime(bool isNonRealtime) noexcept
+{
+    AudioProcessor::setNonRealtime(isNonRealtime);
+    offlineRender.store(isNonRealtime, std::memory_order_relaxed);
+
+    // Most hosts prepare again after this, which applies everything right away. For the others,
+    // the audio thread switches the oversampling now and the threads and latency follow shortly.
+    voiceBank.setHighQuality(isNonRealtime);
+    triggerAsyncUpdate();
+}
+
+int CantinaComposerAudioProcessor::getEffectiveOversampling(int choice) const noexcept
+{
+    // Nobody listens while bouncing, so the distortion gets the cleanest factor whatever it costs.
+    return offlineRender.load(std::memory_order_relaxed) ? (int) oversamplers.size() : choice;
+}
+
+void CantinaComposerAudioProcessor::handleAsyncUpdate()
+{
+    updateRenderPool();
+    updateLatency();
 }
 
-void CantinaComposerAudioProcessor::releaseResources() {}
+void CantinaComposerAudioProcessor::updateLatency()
+{
+    const auto choice = getEffectiveOversampling(static_cast<int>(apvts.getRawParameterValue("OVERSAMPLING")->load()));
+    auto* oversampler = choice > 0 ? oversamplers[(size_t) choice - 1].get() : nullptr;
+
+    // Integer latency was requested from the oversamplers, so this rounding is exact.
+    setLatencySamples(oversampler != nullptr ? juce::roundToInt(oversampler->getLatencyInSamples()) : 0);
+}
+
+void CantinaComposerAudioProcessor::updateRenderPool()
+{
+    const auto multiCore = apvts.getRawParameterValue("MULTICORE")->load() > 0.5f;
+    // One worker per remaining physical core; the host's audio thread takes part as well.
+    // An offline render has the machine to itself, so it uses every core, hyperthreads included.
+    const auto offlineWorkers = offlineWorkerLimit >= 0 ? juce::jmin(offlineWorkerLimit, juce::SystemStats::getNumCpus() - 1)
+                                                        : juce::SystemStats::getNumCpus() - 1;
+    const auto numWorkers = offlineRender.load(std::memory_order_relaxed) ? offlineWorkers
+                          : multiCore                                    ? juce::SystemStats::getNumPhysicalCpus() - 1
+                                                                         : 0;
+    // Pinning only pays off with the machine to ourselves: live, the host's audio thread may sit on any
+    // core, and instances rendering side by side would all pin to the same ones.
+    renderPool.setPinnedToCores(offlineRender.load(std::memory_order_relaxed) && offlineWorkerLimit < 0);
+    renderPool.setNumWorkers(numWorkers);
+}
 
-void CantinaComposerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void CantinaComposerAudioProcessor::processBlock (juce::AudioBuffer<float>& fullBuffer, juce::MidiBuffer& midiMessages)
 {
     // Prevents "denormal" numbers, like 0.000001f numbers from causing performance issues
     juce::ScopedNoDenormals noDenormals;
-    buffer.clear(); // We want to start with a empty buffer
-    
+    // Times the whole call for the load meter (and the profiler, when the benchmark attached one).
+    DspLoadMeter::ScopedBlock blockTimer(loadMeter, profiler, fullBuffer.getNumSamples());
+    fullBuffer.clear(); // We want to start with a empty buffer
+
+    // Hosts may send more samples than they announced, so the chain runs in pieces it was prepared for.
+    // The MIDI stays in one buffer; the synth only picks the events of each piece.
+    const auto numSamples = fullBuffer.getNumSamples();
+    for (int start = 0; start < numSamples; start += maximumBlockSize)
+        processChunk(fullBuffer, midiMessages, start, juce::jmin(maximumBlockSize, numSamples - start));
+}
+
+void CantinaComposerAudioProcessor::processChunk(juce::AudioBuffer<float>& fullBuffer, const juce::MidiBuffer& midiMessages,
+                                                 int startSample, int numSamples)
+{
+    // Take one snapshot of all parameters and hand it to the voices.
+    parameterHandles.load(currentParams);
+    // The effect parameters glide towards the snapshot, sample by sample.
+    parameterRamps.setTargets(currentParams);
+    parameterRamps.fill(numSamples);
+
+    // Switching between one and four layers repartitions the voices, which cuts every note.
+    const auto numLayers = currentParams.getNumLayers();
+    if (numLayers != synth.getNumLayers())
+    {
+        synth.setNumLayers(numLayers);
+        for (auto& filter : layerFilters)
+            filter.reset();
+    }
+
+    voiceBank.beginBlock(currentParams);
+    for (int layer = 0; layer < numLayers; ++layer)
+        synth.setPolyphony(layer, currentParams.layers[(size_t) layer].polyphony);
+
+    using Stage = DspProfiler::Stage;
+
     // 1. Render the synthesizer voices based on MIDI input
-    // This fills the buffer with the raw oscillator sounds.
-    synth.renderNextBlock(buffer, midiMessages, 0, buffer.getNumSamples());
+    // Every layer gets its own mono bus of raw oscillator sound, all from one pass over the voices.
+    {
+        DspLoadMeter::ScopedStage stage(loadMeter, profiler, Stage::synth);
+        for (int layer = 0; layer < numLayers; ++layer)
+            layerBuses.clear(layer, 0, numSamples);
+        synth.renderNextBlock(layerBuses.getArrayOfWritePointers(), midiMessages, startSample, numSamples);
+    }
+
+    // Everything after the synth only sees this piece. The view refers to the host's memory, nothing is copied.
+    juce::AudioBuffer<float> buffer (fullBuffer.getArrayOfWritePointers(), fullBuffer.getNumChannels(), startSample, numSamples);
     juce::dsp::AudioBlock<float> block (buffer); // Juce Wrapper
 
-    // 2. Process the audio through the filter chain (Ladder + Bass)
-    updateFilters(); 
-    filterChain.process(juce::dsp::ProcessContextReplacing<float>(block));
+    // Nothing is playing and the tails have died out: skip the effects and just output silence.
+    // The magnitude check catches a note that started and ended inside this very block.
+    const auto voicesSounding = synth.getNumActiveVoices() > 0;
+    if (effectsAsleep && ! voicesSounding && areLayersSilent(numLayers, numSamples))
+    {
+        DspLoadMeter::ScopedStage stage(loadMeter, profiler, Stage::visualizer);
+        audioBufferQueue.push(buffer);
+        return;
+    }
 
-    // 3. Process the audio through the "Space Wobbler" (Reverb)
-    reverbParams.roomSize = apvts.getRawParameterValue("REVERB_ROOM_SIZE")->load();
-    reverbParams.wetLevel = apvts.getRawParameterValue("REVERB_WET_LEVEL")->load();
-    reverbParams.dryLevel = 1.0f - reverbParams.wetLevel; // Dry level is the opposite of wet to maintain overall volume.
-    reverbParams.damping = apvts.getRawParameterValue("REVERB_DAMPING")->load();
-    reverbParams.width = apvts.getRawParameterValue("REVERB_WIDTH")->load();
-    reverb.setParameters(reverbParams); 
-    reverb.process(juce::dsp::ProcessContextReplacing<float>(block));
+    // 2. Process every layer through its own filter section (Low-pass + Bass) and mix them onto the shared bus
+    {
+        DspLoadMeter::ScopedStage stage(loadMeter, profiler, Stage::filterChain);
 
-    // 4. Process the audio through the "Jizz Gobbler" (Distortion/Bit-Crushing)
-    float gobblerAmount = apvts.getRawParameterValue("JIZZ_GOBBLER_AMOUNT")->load();
+        for (int layer = 0; layer < numLayers; ++layer)
+        {
+            auto* bus = layerBuses.getWritePointer(layer);
+            juce::dsp::AudioBlock<float> layerBlock (&bus, 1, (size_t) numSamples);
+            layerFilters[(size_t) layer].process(layerBlock, parameterRamps.get(ParameterRamps::filterFreq + layer),
+                                                 parameterRamps.get(ParameterRamps::bassGain + layer));
+            buffer.addFrom(0, 0, layerBuses, layer, 0, numSamples);
+        }
 
-    if (gobblerAmount > 0.0f)
+        // The mix is still mono: copy it to the other channels.
+        for (int channel = 1; channel < buffer.getNumChannels(); ++channel)
+            buffer.copyFrom(channel, 0, buffer, 0, 0, numSamples);
+    }
+
+    // 3. Process the audio through the "Space Wobbler" (Reverb)
     {
-        // Map the 0-1 slider to our effect parameters
-        float bitDepth = juce::jmap(gobblerAmount, 0.0f, 1.0f, 16.0f, 4.0f); // From 16-bit down to 4-bit
-        float drive = juce::jmap(gobblerAmount, 0.0f, 1.0f, 1.0f, 5.0f); // From 1x to 5x gain 
+        DspLoadMeter::ScopedStage stage(loadMeter, profiler, Stage::reverb);
+
+        // Switching engines starts the new one from silence rather than from an old tail.
+        if (currentParams.reverbMode != activeReverbMode)
+        {
+            activeReverbMode = currentParams.reverbMode;
+            if (activeReverbMode == 1)
+                convolutionReverb.reset();
+            else
+                reverb.reset();
+        }
+
+        // Keep the input: both engines replace the block with their wet signal only.
+        const auto dryScale = activeReverbMode == 1 ? 1.0f : classicDryScale;
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            juce::FloatVectorOperations::copyWithMultiply(dryBuffer.getWritePointer(channel), buffer.getReadPointer(channel),
+                                                          dryScale, numSamples);
 
-        float numBitLevels = std::pow(2.0f, bitDepth);
+        processReverb(block, numSamples);
 
+        // Dry level is the opposite of wet to maintain overall volume: out = wet * w + dry * (1 - w).
+        const auto wetLevel = parameterRamps.get(ParameterRamps::reverbWetLevel);
         for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
         {
-            auto* channelData = buffer.getWritePointer(channel);
+            auto* out = buffer.getWritePointer(channel);
+            const auto* dry = dryBuffer.getReadPointer(channel);
 
-            for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+            if (wetLevel.isSmoothing())
             {
-                float currentSample = channelData[sample];
-       
-                // Apply drive (distortion)
-                currentSample *= drive;
-                currentSample = std::tanh(currentSample);
-
-                // Apply bit reduction
-                float totalLevels = numBitLevels;
-                float scaledSample = (currentSample * 0.5f + 0.5f) * totalLevels;
-                float quantizedSample = std::floor(scaledSample);
-                float crushedSample = (quantizedSample / totalLevels - 0.5f) * 2.0f;
-                
-                channelData[sample] = crushedSample;
+                juce::FloatVectorOperations::multiply(out, wetLevel.values, numSamples);
+                juce::FloatVectorOperations::add(out, dry, numSamples);
+                juce::FloatVectorOperations::subtractWithMultiply(out, dry, wetLevel.values, numSamples);
             }
+            else
+            {
+                juce::FloatVectorOperations::multiply(out, wetLevel.value, numSamples);
+                juce::FloatVectorOperations::addWithMultiply(out, dry, 1.0f - wetLevel.value, numSamples);
+            }
+        }
+    }
+
+    // The reverb is the last stage with memory, so its output tells whether the chain has rung out.
+    // The gobbler after it is stateless (apart from the oversampler) and does not count.
+    effectsAsleep = updateSilence(buffer, voicesSounding);
+
+    // 4. Process the audio through the "Jizz Gobbler" (Distortion/Bit-Crushing)
+    {
+        DspLoadMeter::ScopedStage stage(loadMeter, profiler, Stage::gobbler);
+        const auto amount = parameterRamps.get(ParameterRamps::gobblerAmount);
+
+        // A newly selected oversampler starts from silence instead of from stale filter state.
+        const auto oversampling = getEffectiveOversampling(currentParams.oversampling);
+        if (oversampling != activeOversampling)
+        {
+            activeOversampling = oversampling;
+            if (activeOversampling > 0)
+                oversamplers[(size_t) activeOversampling - 1]->reset();
+        }
+
+        if (activeOversampling > 0)
+        {
+            // The oversampler runs even while the gobbler is off, so the reported latency always holds.
+            auto& oversampler = *oversamplers[(size_t) activeOversampling - 1];
+            auto oversampledBlock = oversampler.processSamplesUp(block);
+            processGobbler(oversampledBlock, amount, numSamples);
+            oversampler.processSamplesDown(block);
+        }
+        else
+        {
+            processGobbler(block, amount, numSamples);
+        }
+
+        // 5. Apply the output level, the last gain stage. Timed with the gobbler, whose output it scales.
+        const auto outputGain = parameterRamps.get(ParameterRamps::outputGain);
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            if (outputGain.isSmoothing())
+                juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel), outputGain.values, numSamples);
+            else if (! juce::exactlyEqual(outputGain.value, 1.0f))
+                juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel), outputGain.value, numSamples);
         }
     }
 
-    // 5. Push the final audio to the queue for the UI to display
+    // 6. Push the final audio to the queue for the UI to display
+    DspLoadMeter::ScopedStage stage(loadMeter, profiler, Stage::visualizer);
     audioBufferQueue.push(buffer);
 }
 
-void CantinaComposerAudioProcessor::updateFilters()
+bool CantinaComposerAudioProcessor::updateSilence(const juce::AudioBuffer<float>& buffer, bool voicesSounding) noexcept
 {
-    auto freq = apvts.getRawParameterValue("FILTER_FREQ")->load();
-    smoothedFilterFreq.setTargetValue(freq);
-    auto bassGain = apvts.getRawParameterValue("BASS_GAIN")->load();
+    if (voicesSounding || buffer.getMagnitude(0, buffer.getNumSamples()) >= silenceThreshold)
+    {
+        silentSamples = 0;
+        return false;
+    }
+
+    silentSamples = juce::jmin(silentSamples + buffer.getNumSamples(), silenceHoldSamples);
+
+    if (silentSamples < silenceHoldSamples)
+        return false;
+
+    // Going to sleep: drop whatever is left in the filter states, so waking up starts clean.
+    for (auto& filter : layerFilters)
+        filter.reset();
+    reverb.reset();
+    convolutionReverb.reset();
+    for (auto& oversampler : oversamplers)
+        if (oversampler != nullptr)
+            oversampler->reset();
+
+    return true;
+}
 
-    *filterChain.get<0>().coefficients = *juce::dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), smoothedFilterFreq.getNextValue()); 
-    *filterChain.get<1>().coefficients = *juce::dsp::IIR::Coefficients<float>::makeLowShelf(getSampleRate(), 150.0f, 1.0f, juce::Decibels::decibelsToGain(bassGain));
+double CantinaComposerAudioProcessor::getTailLengthSeconds() const
+{
+    // Released notes keep sounding for their release time before the reverb even starts decaying.
+    const auto numLayers = apvts.getRawParameterValue("MULTITIMBRAL")->load() > 0.5f ? InstrumentLayers::maxLayers : 1;
+    auto release = 0.0;
+    for (int layer = 0; layer < numLayers; ++layer)
+        release = juce::jmax(release, (double) apvts.getRawParameterValue(InstrumentLayers::getParameterID("RELEASE", layer))->load());
+
+    // The convolution responses are trimmed to a fixed maximum length.
+    if (static_cast<int>(apvts.getRawParameterValue("REVERB_MODE")->load()) == 1)
+        return release + ConvolutionReverb::maxImpulseSeconds;
+
+    // juce::dsp::Reverb (Freeverb) feeds its combs back with roomSize * 0.28 + 0.7, and its longest
+    // comb is 1617 samples at 44.1 kHz. The tail has decayed by 60 dB after enough trips around it
+    // for feedback^n to reach 1/1000. Damping only shortens that, so this is an upper bound.
+    const auto roomSize = (double) apvts.getRawParameterValue("REVERB_ROOM_SIZE")->load();
+    const auto feedback = roomSize * 0.28 + 0.7;
+    const auto longestComb = 1617.0 / 44100.0;
+    const auto reverbTail = 3.0 * longestComb / -std::log10(feedback);
+
+    return release + reverbTail;
 }
 
+void CantinaComposerAudioProcessor::updateReverbSettings(float roomSize, float damping, float width) noexcept
+{
+    if (juce::exactlyEqual(roomSize, appliedRoomSize) && juce::exactlyEqual(damping, appliedDamping)
+        && juce::exactlyEqual(width, appliedWidth))
+        return;
+
+    appliedRoomSize = roomSize;
+    appliedDamping = damping;
+    appliedWidth = width;
 
+    reverbParams.roomSize = appliedRoomSize;
+    reverbParams.damping = appliedDamping;
+    reverbParams.width = appliedWidth;
+    reverb.setParameters(reverbParams);
+    convolutionReverb.setParameters(appliedRoomSize, appliedDamping, appliedWidth);
+}
 
-void CantinaComposerAudioProcessor::setPreset(int presetIndex)
+void CantinaComposerAudioProcessor::processReverb(juce::dsp::AudioBlock<float>& block, int numSamples) noexcept
 {
+    const auto roomSize = parameterRamps.get(ParameterRamps::reverbRoomSize);
+    const auto damping = parameterRamps.get(ParameterRamps::reverbDamping);
+    const auto width = parameterRamps.get(ParameterRamps::reverbWidth);
 
-    auto* waveParam = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("WAVE"));
-    auto* attackParam = apvts.getParameter("ATTACK");
-    auto* decayParam = apvts.getParameter("DECAY");
-    auto* sustainParam = apvts.getParameter("SUSTAIN");
-    auto* releaseParam = apvts.getParameter("RELEASE");
-    auto* freqParam = apvts.getParameter("FILTER_FREQ");
-    auto* bassParam = apvts.getParameter("BASS_GAIN");
+    auto process = [this](juce::dsp::AudioBlock<float>& subBlock)
+    {
+        if (activeReverbMode == 1)
+            convolutionReverb.process(subBlock);
+        else
+            reverb.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+    };
 
-    if (!waveParam || !attackParam || !decayParam || !sustainParam || !releaseParam || !freqParam || !bassParam)
+    if (! roomSize.isSmoothing() && ! damping.isSmoothing() && ! width.isSmoothing())
     {
-        jassertfalse;
+        // Returns right away unless a ramp has just ended on a new value.
+        updateReverbSettings(roomSize.value, damping.value, width.value);
+        process(block);
         return;
     }
 
-    auto setParam = [](juce::RangedAudioParameter* param, float value) {
-        param->setValueNotifyingHost(param->getNormalisableRange().convertTo0to1(value));
-    };
+    // juce::dsp::Reverb still smooths its own gains in between, so the steps don't click.
+    for (int start = 0; start < numSamples; start += ParameterRamps::microBlockSize)
+    {
+        const auto length = juce::jmin(ParameterRamps::microBlockSize, numSamples - start);
+        const auto end = start + length - 1;
+        updateReverbSettings(roomSize[end], damping[end], width[end]);
 
+        auto subBlock = block.getSubBlock((size_t) start, (size_t) length);
+        process(subBlock);
+    }
+}
+
+void CantinaComposerAudioProcessor::processGobbler(juce::dsp::AudioBlock<float>& block, ParameterRamps::Ramp amount,
+                                                   int numSamples) noexcept
+{
+    if (! amount.isSmoothing())
+    {
+        // Only recomputes the drive and the levels when the knob has moved. Does nothing at 0.
+        gobbler.setAmount(amount.value);
+        gobbler.process(block);
+        return;
+    }
 
-    switch (presetIndex)
+    // The ramp runs at the host rate, the block may be oversampled.
+    const auto factor = (int) block.getNumSamples() / numSamples;
+    for (int start = 0; start < numSamples; start += ParameterRamps::microBlockSize)
     {
-        case 0: // Kloo Horn
-            *waveParam = 0;
-            setParam(attackParam, 0.08f);
-            setParam(decayParam, 0.3f);
-            setParam(sustainParam, 0.8f);
-            setParam(releaseParam, 0.4f);
-            setParam(freqParam, 8000.0f);
-            setParam(bassParam, -6.0f);
-            break;
-
-        case 1: // Fanfar
-            *waveParam = 0;
-            setParam(attackParam, 0.1f);
-            setParam(decayParam, 0.5f);
-            setParam(sustainParam, 0.2f);
-            setParam(releaseParam, 0.3f);
-            setParam(freqParam, 12000.0f);
-            setParam(bassParam, 0.0f);
-            break;
-
-        case 2: // Gasan String_Drum
-            *waveParam = 1;
-            setParam(attackParam, 0.02f);
-            setParam(decayParam, 0.6f);
-            setParam(sustainParam, 0.5f);
-            setParam(releaseParam, 0.8f);
-            setParam(freqParam, 6500.0f);
-            setParam(bassParam, 3.0f);
-            break;
-
-        case 3: // Omni Box
-            *waveParam = 2; 
-            setParam(attackParam, 0.12f);
-            setParam(decayParam, 0.1f);
-            setParam(sustainParam, 1.0f);
-            setParam(releaseParam, 0.2f);
-            setParam(freqParam, 4000.0f);
-            setParam(bassParam, -2.0f);
-            break;
+        const auto length = juce::jmin(ParameterRamps::microBlockSize, numSamples - start);
+        gobbler.setAmount(amount[start + length - 1]);
+
+        auto subBlock = block.getSubBlock((size_t) (start * factor), (size_t) (length * factor));
+        gobbler.process(subBlock);
     }
 }
 
+bool CantinaComposerAudioProcessor::areLayersSilent(int numLayers, int numSamples) const noexcept
+{
+    for (int layer = 0; layer < numLayers; ++layer)
+        if (layerBuses.getMagnitude(layer, 0, numSamples) >= silenceThreshold)
+            return false;
+
+    return true;
+}
+
+void CantinaComposerAudioProcessor::setPreset(int presetIndex, int layer)
+{
+    // The factory presets come first in the library, so the "PRESET" index is a library index.
+    if (! presetLibrary.applyPreset(presetIndex, layer))
+        jassertfalse;
+}
+
 
 juce::AudioProcessorEditor* CantinaComposerAudioProcessor::createEditor()
 {
@@ -232,13 +563,19 @@ juce::AudioProcessorEditor* CantinaComposerAudioProcessor::createEditor()
 
 void CantinaComposerAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    auto state = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    stateChunk.write(destData);
 }
 
 void CantinaComposerAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    // The chunk holds every value as it was saved, so there is no preset to re-apply on top.
+    if (StateChunk::isStateChunk(data, sizeInBytes))
+    {
+        stateChunk.read(data, sizeInBytes);
+        return;
+    }
+
+    // Sessions saved before the binary chunk contain XML.
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
     if (xmlState != nullptr)
     {
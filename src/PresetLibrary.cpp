@@ -0,0 +1,393 @@
+#include "PresetLibrary.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+
+namespace
+{
+    constexpr char bankMagic[4] = { 'C', 'C', 'P', 'B' };
+    constexpr juce::uint32 bankVersion = 1;
+    constexpr size_t headerSize = 8 * sizeof(juce::uint32);
+    /// @brief The name, category and tags offsets in front of the values of every record.
+    constexpr size_t recordHeaderSize = 3 * sizeof(juce::uint32);
+
+    /// @brief The parameters the factory presets set, in the order of FactoryPreset::values.
+    constexpr std::array<const char*, 12> factoryParameterIDs { "WAVE", "ATTACK", "DECAY", "SUSTAIN", "RELEASE", "FILTER_FREQ", "BASS_GAIN",
+                                                                "VOICE_CUTOFF", "VOICE_RESONANCE", "VOICE_ENV_AMOUNT", "VOICE_ENV_DECAY", "VOICE_KEYTRACK" };
+
+    struct FactoryPreset
+    {
+        const char* name;
+        const char* category;
+        const char* tags;
+        std::array<float, factoryParameterIDs.size()> values;
+    };
+
+    // The string-drum is the only pluck: its voice filter snaps shut after every note.
+    constexpr std::array<FactoryPreset, 4> factoryPresets {{
+        { "Kloo Horn (Flute)",    "Winds",      "lead,soft",     { 0.0f, 0.08f, 0.3f, 0.8f, 0.4f, 8000.0f,  -6.0f, 20000.0f, 0.707f, 0.0f, 0.3f,  0.0f } },
+        { "Fanfar (Steel Drum)",  "Percussion", "mallet,bright", { 0.0f, 0.1f,  0.5f, 0.2f, 0.3f, 12000.0f,  0.0f, 20000.0f, 0.707f, 0.0f, 0.3f,  0.0f } },
+        { "Gasan String-drum",    "Percussion", "plucked,bass",  { 1.0f, 0.02f, 0.6f, 0.5f, 0.8f, 6500.0f,   3.0f, 600.0f,   1.4f,   4.0f, 0.18f, 0.5f } },
+        { "Ommni Box (Clarinet)", "Winds",      "lead,reed",     { 2.0f, 0.12f, 0.1f, 1.0f, 0.2f, 4000.0f,  -2.0f, 20000.0f, 0.707f, 0.0f, 0.3f,  0.0f } },
+    }};
+
+    void setParameter(juce::RangedAudioParameter* parameter, float value)
+    {
+        // Unknown parameters of newer banks and values a preset leaves alone are skipped.
+        if (parameter != nullptr && ! std::isnan(value))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+}
+
+PresetLibrary::PresetLibrary(juce::AudioProcessorValueTreeState& apvts)
+    : valueTreeState(apvts)
+{
+    for (int layer = 0; layer < InstrumentLayers::maxLayers; ++layer)
+    {
+        for (const auto* id : factoryParameterIDs)
+        {
+            factoryParameters[(size_t) layer].push_back(getLayerParameter(id, layer));
+            jassert(factoryParameters[(size_t) layer].back() != nullptr);
+        }
+    }
+
+    rebuildIndex();
+}
+
+juce::RangedAudioParameter* PresetLibrary::getLayerParameter(const juce::String& parameterID, int layer) const
+{
+    // The other layers share everything that is not a layer parameter with layer 0, so their presets leave it alone.
+    if (layer == 0)
+        return valueTreeState.getParameter(parameterID);
+
+    return InstrumentLayers::isLayerParameter(parameterID) ? valueTreeState.getParameter(InstrumentLayers::getParameterID(parameterID, layer))
+                                                           : nullptr;
+}
+
+int PresetLibrary::getNumFactoryPresets() noexcept
+{
+    return (int) factoryPresets.size();
+}
+
+juce::StringArray PresetLibrary::getFactoryPresetNames()
+{
+    juce::StringArray names;
+    for (const auto& preset : factoryPresets)
+        names.add(preset.name);
+    return names;
+}
+
+juce::File PresetLibrary::getDefaultBankFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("CantinaComposer")
+        .getChildFile("Presets.ccpb");
+}
+
+juce::uint32 PresetLibrary::readUInt(size_t byteOffset) const noexcept
+{
+    return juce::ByteOrder::littleEndianInt(bankData + byteOffset);
+}
+
+std::string_view PresetLibrary::getBankString(juce::uint32 offset) const noexcept
+{
+    // The string block ends with a terminator, so every valid offset reads a terminated string.
+    return std::string_view(bankData + stringsOffset + offset);
+}
+
+const char* PresetLibrary::getRecord(int bankIndex) const noexcept
+{
+    return bankData + recordsOffset + (size_t) bankIndex * recordStride;
+}
+
+bool PresetLibrary::openBank(const juce::File& bankFile)
+{
+    closeBank();
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(bankFile, juce::MemoryMappedFile::readOnly);
+    const auto* data = static_cast<const char*>(mapped->getData());
+    const auto size = mapped->getSize();
+
+    if (data == nullptr || size < headerSize || std::memcmp(data, bankMagic, sizeof(bankMagic)) != 0)
+        return false;
+
+    bank = std::move(mapped);
+    bankData = data;
+    bankSize = size;
+
+    // All sizes are checked in 64 bits, so a corrupt header can't wrap around.
+    const auto version = readUInt(4);
+    const auto numPresets = (juce::uint64) readUInt(8);
+    const auto numParameters = (juce::uint64) readUInt(12);
+    const auto parameterIdsOffset = (juce::uint64) readUInt(16);
+    const auto stride = recordHeaderSize + numParameters * sizeof(float);
+    recordsOffset = readUInt(20);
+    stringsOffset = readUInt(24);
+    stringsSize = readUInt(28);
+
+    const auto valid = version == bankVersion
+                    && numPresets <= (juce::uint64) std::numeric_limits<int>::max() - factoryPresets.size()
+                    && parameterIdsOffset + numParameters * sizeof(juce::uint32) <= bankSize
+                    && (juce::uint64) recordsOffset + numPresets * stride <= bankSize
+                    && stringsSize > 0
+                    && (juce::uint64) stringsOffset + stringsSize <= bankSize
+                    && bankData[stringsOffset + stringsSize - 1] == '\0';
+
+    if (! valid)
+    {
+        closeBank();
+        return false;
+    }
+
+    numBankPresets = (int) numPresets;
+    numBankParameters = (int) numParameters;
+    recordStride = (size_t) stride;
+
+    for (int p = 0; p < numBankParameters; ++p)
+    {
+        const auto idOffset = readUInt((size_t) parameterIdsOffset + (size_t) p * sizeof(juce::uint32));
+        if (idOffset >= stringsSize)
+        {
+            closeBank();
+            return false;
+        }
+
+        const auto id = getBankString(idOffset);
+        const auto parameterID = juce::String::fromUTF8(id.data(), (int) id.size());
+        for (int layer = 0; layer < InstrumentLayers::maxLayers; ++layer)
+            bankParameters[(size_t) layer].push_back(getLayerParameter(parameterID, layer));
+    }
+
+    // Every string reference is checked once here, so the accessors never have to.
+    for (int i = 0; i < numBankPresets; ++i)
+    {
+        const auto recordOffset = (size_t) (getRecord(i) - bankData);
+        for (size_t field = 0; field < 3; ++field)
+        {
+            if (readUInt(recordOffset + field * sizeof(juce::uint32)) >= stringsSize)
+            {
+                closeBank();
+                return false;
+            }
+        }
+    }
+
+    rebuildIndex();
+    return true;
+}
+
+void PresetLibrary::closeBank()
+{
+    bank.reset();
+    bankData = nullptr;
+    bankSize = 0;
+    numBankPresets = 0;
+    numBankParameters = 0;
+    recordsOffset = recordStride = stringsOffset = stringsSize = 0;
+    for (auto& parameters : bankParameters)
+        parameters.clear();
+
+    rebuildIndex();
+}
+
+std::string_view PresetLibrary::getName(int index) const noexcept
+{
+    if (index < getNumFactoryPresets())
+        return factoryPresets[(size_t) index].name;
+
+    return getBankString(juce::ByteOrder::littleEndianInt(getRecord(index - getNumFactoryPresets())));
+}
+
+std::string_view PresetLibrary::getCategory(int index) const noexcept
+{
+    if (index < getNumFactoryPresets())
+        return factoryPresets[(size_t) index].category;
+
+    return getBankString(juce::ByteOrder::littleEndianInt(getRecord(index - getNumFactoryPresets()) + 4));
+}
+
+std::string_view PresetLibrary::getTags(int index) const noexcept
+{
+    if (index < getNumFactoryPresets())
+        return factoryPresets[(size_t) index].tags;
+
+    return getBankString(juce::ByteOrder::littleEndianInt(getRecord(index - getNumFactoryPresets()) + 8));
+}
+
+void PresetLibrary::addToIndex(int index)
+{
+    // The first preset of a name wins, so user banks can't shadow the factory presets.
+    nameIndex.emplace(getName(index), index);
+    categoryIndex[getCategory(index)].push_back(index);
+
+    auto tags = getTags(index);
+    while (! tags.empty())
+    {
+        const auto comma = tags.find(',');
+        auto tag = tags.substr(0, comma);
+        tags = comma == std::string_view::npos ? std::string_view() : tags.substr(comma + 1);
+
+        while (! tag.empty() && tag.front() == ' ')
+            tag.remove_prefix(1);
+        while (! tag.empty() && tag.back() == ' ')
+            tag.remove_suffix(1);
+
+        if (! tag.empty())
+            tagIndex[tag].push_back(index);
+    }
+}
+
+void PresetLibrary::rebuildIndex()
+{
+    nameIndex.clear();
+    categoryIndex.clear();
+    tagIndex.clear();
+    nameIndex.reserve((size_t) getNumPresets());
+
+    for (int i = 0; i < getNumPresets(); ++i)
+        addToIndex(i);
+}
+
+int PresetLibrary::findByName(std::string_view name) const noexcept
+{
+    const auto found = nameIndex.find(name);
+    return found != nameIndex.end() ? found->second : -1;
+}
+
+std::vector<std::string_view> PresetLibrary::getCategories() const
+{
+    std::vector<std::string_view> categories;
+    categories.reserve(categoryIndex.size());
+
+    for (const auto& [category, presets] : categoryIndex)
+        categories.push_back(category);
+
+    std::sort(categories.begin(), categories.end());
+    return categories;
+}
+
+const std::vector<int>& PresetLibrary::getPresetsInCategory(std::string_view category) const noexcept
+{
+    static const std::vector<int> none;
+    const auto found = categoryIndex.find(category);
+    return found != categoryIndex.end() ? found->second : none;
+}
+
+const std::vector<int>& PresetLibrary::getPresetsWithTag(std::string_view tag) const noexcept
+{
+    static const std::vector<int> none;
+    const auto found = tagIndex.find(tag);
+    return found != tagIndex.end() ? found->second : none;
+}
+
+bool PresetLibrary::applyPreset(int index, int layer) const
+{
+    if (index < 0 || index >= getNumPresets() || layer < 0 || layer >= InstrumentLayers::maxLayers)
+        return false;
+
+    if (index < getNumFactoryPresets())
+    {
+        const auto& preset = factoryPresets[(size_t) index];
+        const auto& parameters = factoryParameters[(size_t) layer];
+        for (size_t p = 0; p < parameters.size(); ++p)
+            setParameter(parameters[p], preset.values[p]);
+
+        return true;
+    }
+
+    // Straight out of the mapping: the record's values are in the order of the bank's parameter columns.
+    const auto* values = getRecord(index - getNumFactoryPresets()) + recordHeaderSize;
+    const auto& parameters = bankParameters[(size_t) layer];
+    for (int p = 0; p < numBankParameters; ++p)
+    {
+        const auto bits = juce::ByteOrder::littleEndianInt(values + (size_t) p * sizeof(float));
+        setParameter(parameters[(size_t) p], std::bit_cast<float>(bits));
+    }
+
+    return true;
+}
+
+bool PresetLibrary::writeBank(const juce::File& bankFile, const std::vector<BankPreset>& presets)
+{
+    // The parameter columns are the union of everything the presets set, in order of appearance.
+    juce::StringArray parameterIDs;
+    for (const auto& preset : presets)
+        for (const auto& [id, value] : preset.values)
+            parameterIDs.addIfNotAlreadyThere(id);
+
+    // Each distinct string is stored once. Offset 0 is the empty string.
+    juce::MemoryOutputStream strings;
+    std::map<juce::String, juce::uint32> stringOffsets;
+    auto addString = [&](const juce::String& text)
+    {
+        const auto [it, inserted] = stringOffsets.emplace(text, (juce::uint32) strings.getDataSize());
+        if (inserted)
+        {
+            strings.write(text.toRawUTF8(), text.getNumBytesAsUTF8());
+            strings.writeByte(0);
+        }
+        return it->second;
+    };
+    addString({});
+
+    std::vector<juce::uint32> idOffsets;
+    for (const auto& id : parameterIDs)
+        idOffsets.push_back(addString(id));
+
+    const auto numParameters = (size_t) parameterIDs.size();
+    const auto recordStride = recordHeaderSize + numParameters * sizeof(float);
+    const auto parameterIdsOffset = headerSize;
+    const auto recordsOffset = parameterIdsOffset + numParameters * sizeof(juce::uint32);
+
+    juce::MemoryOutputStream records;
+    records.preallocate(presets.size() * recordStride);
+    std::vector<float> values(numParameters);
+
+    for (const auto& preset : presets)
+    {
+        records.writeInt((int) addString(preset.name));
+        records.writeInt((int) addString(preset.category));
+        records.writeInt((int) addString(preset.tags));
+
+        std::fill(values.begin(), values.end(), std::numeric_limits<float>::quiet_NaN());
+        for (const auto& [id, value] : preset.values)
+            values[(size_t) parameterIDs.indexOf(id)] = value;
+
+        for (auto value : values)
+            records.writeFloat(value);
+    }
+
+    const auto stringsOffset = recordsOffset + records.getDataSize();
+
+    // Written next to the target and swapped in at the end, so a failed export never leaves a broken bank.
+    juce::TemporaryFile temporary(bankFile);
+    {
+        juce::FileOutputStream out(temporary.getFile());
+        if (! out.openedOk())
+            return false;
+
+        out.write(bankMagic, sizeof(bankMagic));
+        out.writeInt((int) bankVersion);
+        out.writeInt((int) presets.size());
+        out.writeInt((int) numParameters);
+        out.writeInt((int) parameterIdsOffset);
+        out.writeInt((int) recordsOffset);
+        out.writeInt((int) stringsOffset);
+        out.writeInt((int) strings.getDataSize());
+
+        for (auto offset : idOffsets)
+            out.writeInt((int) offset);
+
+        out.write(records.getData(), records.getDataSize());
+        out.write(strings.getData(), strings.getDataSize());
+        out.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return temporary.overwriteTargetFileWithTemporary();
+}
@@ -0,0 +1,110 @@
+#include "StateChunk.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr char chunkMagic[4] = { 'C', 'C', 'S', 'T' };
+
+    void writeUInt(char* dest, juce::uint32 value) noexcept
+    {
+        const auto littleEndian = juce::ByteOrder::swapIfBigEndian(value);
+        std::memcpy(dest, &littleEndian, sizeof(littleEndian));
+    }
+}
+
+StateChunk::StateChunk(juce::AudioProcessor& processor)
+{
+    for (auto* parameter : processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            entries.push_back({ hashParameterID(ranged->getParameterID()), ranged, entries.size() });
+
+    sortedEntries = entries;
+    restored.resize(entries.size());
+    std::sort(sortedEntries.begin(), sortedEntries.end(), [](const Entry& a, const Entry& b) { return a.idHash < b.idHash; });
+
+    // Two IDs with the same hash would overwrite each other. Rename one of them.
+    jassert(std::adjacent_find(sortedEntries.begin(), sortedEntries.end(),
+                               [](const Entry& a, const Entry& b) { return a.idHash == b.idHash; }) == sortedEntries.end());
+}
+
+juce::uint32 StateChunk::hashParameterID(const juce::String& parameterID) noexcept
+{
+    juce::uint32 hash = 2166136261u;
+    for (auto* c = parameterID.toRawUTF8(); *c != 0; ++c)
+        hash = (hash ^ (juce::uint8) *c) * 16777619u;
+    return hash;
+}
+
+bool StateChunk::isStateChunk(const void* data, int sizeInBytes) noexcept
+{
+    return data != nullptr && sizeInBytes >= (int) headerSize && std::memcmp(data, chunkMagic, sizeof(chunkMagic)) == 0;
+}
+
+const StateChunk::Entry* StateChunk::find(juce::uint32 idHash) const noexcept
+{
+    const auto found = std::lower_bound(sortedEntries.begin(), sortedEntries.end(), idHash,
+                                        [](const Entry& entry, juce::uint32 hash) { return entry.idHash < hash; });
+    return found != sortedEntries.end() && found->idHash == idHash ? &*found : nullptr;
+}
+
+void StateChunk::write(juce::MemoryBlock& destData) const
+{
+    // The host usually hands over the same block every time, so this only allocates once.
+    destData.setSize(getSize());
+    auto* out = static_cast<char*>(destData.getData());
+
+    std::memcpy(out, chunkMagic, sizeof(chunkMagic));
+    writeUInt(out + 4, currentVersion);
+    writeUInt(out + 8, (juce::uint32) entries.size());
+    out += headerSize;
+
+    for (const auto& entry : entries)
+    {
+        const auto value = entry.parameter->convertFrom0to1(entry.parameter->getValue());
+        writeUInt(out, entry.idHash);
+        writeUInt(out + 4, std::bit_cast<juce::uint32>(value));
+        out += entrySize;
+    }
+}
+
+bool StateChunk::read(const void* data, int sizeInBytes)
+{
+    if (! isStateChunk(data, sizeInBytes))
+        return false;
+
+    const auto* in = static_cast<const char*>(data);
+    const auto version = juce::ByteOrder::littleEndianInt(in + 4);
+    const auto numEntries = (size_t) juce::ByteOrder::littleEndianInt(in + 8);
+
+    // A newer version may mean anything, so it is better to keep the current sound than to guess.
+    if (version == 0 || version > currentVersion || numEntries > ((size_t) sizeInBytes - headerSize) / entrySize)
+        return false;
+
+    in += headerSize;
+
+    // Everything the chunk doesn't mention starts from its default, like a fresh instance.
+    std::fill(restored.begin(), restored.end(), false);
+
+    for (size_t i = 0; i < numEntries; ++i, in += entrySize)
+    {
+        const auto idHash = juce::ByteOrder::littleEndianInt(in);
+        const auto value = std::bit_cast<float>(juce::ByteOrder::littleEndianInt(in + 4));
+
+        // Fast path: the chunk was written by this layout, so entry i is parameter i.
+        const auto* entry = i < entries.size() && entries[i].idHash == idHash ? &entries[i] : find(idHash);
+        if (entry == nullptr || std::isnan(value))
+            continue;
+
+        entry->parameter->setValueNotifyingHost(entry->parameter->convertTo0to1(value));
+        restored[entry->index] = true;
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i)
+        if (! restored[i])
+            entries[i].parameter->setValueNotifyingHost(entries[i].parameter->getDefaultValue());
+
+    return true;
+}
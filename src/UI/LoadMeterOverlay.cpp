@@ -0,0 +1,64 @@
+#include "LoadMeterOverlay.hpp"
+
+LoadMeterOverlay::LoadMeterOverlay(const DspLoadMeter& meter) : loadMeter(meter)
+{
+    startTimerHz(4); // The meter publishes twice per second, so this is plenty.
+}
+
+LoadMeterOverlay::~LoadMeterOverlay()
+{
+    stopTimer();
+}
+
+int LoadMeterOverlay::getPreferredHeight() const noexcept
+{
+    return expanded ? rowHeight * (DspLoadMeter::numEntries + 2) + 8 : rowHeight + 8;
+}
+
+void LoadMeterOverlay::timerCallback()
+{
+    for (int entry = 0; entry < DspLoadMeter::numEntries; ++entry)
+        stats[(size_t) entry] = loadMeter.getStats(entry);
+
+    peakLoadPercent = loadMeter.getPeakLoadPercent();
+    repaint();
+}
+
+void LoadMeterOverlay::mouseUp(const juce::MouseEvent&)
+{
+    expanded = ! expanded;
+    setSize(getWidth(), getPreferredHeight());
+}
+
+void LoadMeterOverlay::paint(juce::Graphics& g)
+{
+    g.setColour(juce::Colours::black.withAlpha(0.7f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 4.0f);
+
+    g.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 11.0f, juce::Font::plain));
+    auto area = getLocalBounds().reduced(6, 4);
+
+    const auto& total = stats[(size_t) DspLoadMeter::totalEntry];
+    // Green while there is plenty of headroom, red once a single block came close to the deadline.
+    const auto colour = peakLoadPercent > 80.0f ? juce::Colours::red
+                      : peakLoadPercent > 50.0f ? juce::Colours::orange
+                                                : juce::Colours::lightgreen;
+    g.setColour(colour);
+    g.drawText(juce::String::formatted("DSP %5.1f%%  peak %5.1f%%", total.loadPercent, peakLoadPercent),
+               area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+
+    if (! expanded)
+        return;
+
+    g.setColour(juce::Colours::lightgrey);
+    g.drawText(juce::String::formatted("%-11s %7s %7s %7s %6s", "stage", "mean", "p99", "max", "load"),
+               area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+
+    for (int entry = 0; entry < DspLoadMeter::numEntries; ++entry)
+    {
+        const auto& s = stats[(size_t) entry];
+        g.drawText(juce::String::formatted("%-11s %7.1f %7.1f %7.1f %5.1f%%", DspLoadMeter::getEntryName(entry),
+                                           s.meanMicros, s.p99Micros, s.maxMicros, s.loadPercent),
+                   area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+    }
+}
@@ -4,7 +4,8 @@
  * @brief Constructs the StaticWaveformVisualizer.
  *
  * It registers itself as a listener for the "WAVE" and "JIZZ_GOBBLER_AMOUNT"
- * parameters so it can automatically update when they are changed.
+ * parameters so it can automatically update when they are changed. setLayer()
+ * moves the "WAVE" listener to another instrument layer.
  */
 StaticWaveformVisualizer::StaticWaveformVisualizer(juce::AudioProcessorValueTreeState& apvts) : valueTreeState(apvts)
 {
@@ -19,15 +20,16 @@ StaticWaveformVisualizer::StaticWaveformVisualizer(juce::AudioProcessorValueTree
 
 StaticWaveformVisualizer::~StaticWaveformVisualizer()
 {
-    valueTreeState.removeParameterListener("WAVE", this);
+    valueTreeState.removeParameterListener(InstrumentLayers::getParameterID("WAVE", layer), this);
     valueTreeState.removeParameterListener("JIZZ_GOBBLER_AMOUNT", this);
+    cancelPendingUpdate();
 }
 
 /**
  * @brief The main drawing function.
  *
- * This function generates the points for the selected waveform, applies a simulated
- * version of the "Jizz Gobbler" effect, and draws the resulting path.
+ * Just draws the background and the cached curve. The curve itself is only
+ * recomputed when the parameters or the pixel scale have changed.
  */
 void StaticWaveformVisualizer::paint(juce::Graphics& g)
 {
@@ -35,10 +37,65 @@ void StaticWaveformVisualizer::paint(juce::Graphics& g)
     g.setColour(juce::Colours::darkgrey.brighter(0.1f));
     g.fillRoundedRectangle(bounds, 5.0f);
 
+    // Render at the physical resolution, so the cached curve stays sharp on high-DPI screens.
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (! juce::exactlyEqual(scale, builtScale) || ! curveImage.isValid())
+        rebuildCurve(scale);
+
+    g.drawImage(curveImage, getLocalBounds().toFloat());
+}
+
+void StaticWaveformVisualizer::resized()
+{
+    // Force a rebuild at the new size on the next paint.
+    curveImage = {};
+}
+
+void StaticWaveformVisualizer::setLayer(int newLayer)
+{
+    if (newLayer == layer)
+        return;
+
+    // Removing the listener waits for a callback that is in progress, so no change of the old layer arrives after this.
+    valueTreeState.removeParameterListener(InstrumentLayers::getParameterID("WAVE", layer), this);
+    layer = newLayer;
+
+    const auto waveID = InstrumentLayers::getParameterID("WAVE", layer);
+    valueTreeState.addParameterListener(waveID, this);
+    currentWaveType = static_cast<int>(valueTreeState.getRawParameterValue(waveID)->load());
+    triggerAsyncUpdate();
+}
+
+void StaticWaveformVisualizer::handleAsyncUpdate()
+{
+    if (currentWaveType.load() == builtWaveType && juce::exactlyEqual(gobblerAmount.load(), builtGobblerAmount))
+        return;
+
+    rebuildCurve(builtScale > 0.0f ? builtScale : 1.0f);
+    repaint();
+}
+
+/**
+ * @brief Generates the points for the selected waveform, applies the "Jizz Gobbler"
+ * kernel and renders the resulting path into curveImage.
+ */
+void StaticWaveformVisualizer::rebuildCurve(float scale)
+{
+    builtWaveType = currentWaveType.load();
+    builtGobblerAmount = gobblerAmount.load();
+    builtScale = scale;
+
+    const auto width = juce::jmax(1, juce::roundToInt((float) getWidth() * scale));
+    const auto height = juce::jmax(1, juce::roundToInt((float) getHeight() * scale));
+    curveImage = juce::Image(juce::Image::ARGB, width, height, true);
+
+    auto bounds = getLocalBounds().toFloat().reduced(5.0f);
+
     juce::Path path;
     path.startNewSubPath(bounds.getX(), bounds.getCentreY());
 
     const int numPoints = getWidth(); // Use one point per horizontal pixel for a smooth curve.
+    gobbler.setAmount(builtGobblerAmount);
 
     for (int i = 0; i < numPoints; ++i)
     {
@@ -47,53 +104,45 @@ void StaticWaveformVisualizer::paint(juce::Graphics& g)
         float angle = x_norm * juce::MathConstants<float>::twoPi;
         float sample = 0.0f;
 
-        switch (currentWaveType)
+        switch (builtWaveType)
         {
             case 0: sample = std::sin(angle); break; // Sine
             case 1: sample = juce::jmap(fmod(angle, juce::MathConstants<float>::twoPi), 0.0f, juce::MathConstants<float>::twoPi, -1.0f, 1.0f); break; // Saw
             case 2: sample = std::copysign(1.0f, std::sin(angle)); break; // Square
         }
         
-        // 2. Apply the "Jizz Gobbler" effect simulation.
-        if (gobblerAmount > 0.0f)
-        {
-            float drive = juce::jmap(gobblerAmount, 0.0f, 1.0f, 1.0f, 5.0f);
-            float bitDepth = juce::jmap(gobblerAmount, 0.0f, 1.0f, 16.0f, 4.0f);
-            float numBitLevels = std::pow(2.0f, bitDepth);
-            
-            // Apply drive and distortion
-            sample *= drive;
-            sample = std::tanh(sample);
-            
-            // Apply bit reduction
-            float scaledSample = (sample * 0.5f + 0.5f) * numBitLevels;
-            float quantizedSample = std::floor(scaledSample);
-            sample = (quantizedSample / numBitLevels - 0.5f) * 2.0f;
-        }
+        // 2. Apply the "Jizz Gobbler" effect, with the processor's own kernel.
+        if (gobbler.isActive())
+            sample = gobbler.processSample(sample);
 
-        // 3. Map the final sample to screen coordinates and draw.
+        // 3. Map the final sample to screen coordinates.
         float x = bounds.getX() + x_norm * bounds.getWidth();
         float y = juce::jmap(sample, -1.0f, 1.0f, bounds.getBottom(), bounds.getY());
         path.lineTo(x, y);
     }
 
-    g.setColour(juce::Colours::orange);
-    g.strokePath(path, juce::PathStrokeType(2.0f));
+    juce::Graphics imageGraphics(curveImage);
+    imageGraphics.addTransform(juce::AffineTransform::scale(scale));
+    imageGraphics.setColour(juce::Colours::orange);
+    imageGraphics.strokePath(path, juce::PathStrokeType(2.0f));
 }
 
 /**
  * @brief This callback is triggered when a listened-to parameter changes.
- * It updates the cached values and triggers a repaint to update the display.
+ * It may run on any thread, so it only stores the value; the curve is rebuilt
+ * later on the message thread, once for any number of changes.
  */
 void StaticWaveformVisualizer::parameterChanged(const juce::String& parameterID, float newValue)
 {
-    if (parameterID == "WAVE")
+    // The only other parameter listened to is the "WAVE" of the current layer. Comparing against
+    // layer here would race with setLayer().
+    if (parameterID == "JIZZ_GOBBLER_AMOUNT")
     {
-        currentWaveType = static_cast<int>(newValue);
+        gobblerAmount = newValue;
     }
-    else if (parameterID == "JIZZ_GOBBLER_AMOUNT")
+    else
     {
-        gobblerAmount = newValue;
+        currentWaveType = static_cast<int>(newValue);
     }
-    repaint();
+    triggerAsyncUpdate();
 }
@@ -14,7 +14,7 @@ WaveformVisualizer::~WaveformVisualizer()
  * @brief The main drawing function for the visualizer.
  *
  * This function is called every time `repaint()` is triggered by our timer.
- * It's responsible for fetching the latest audio data and drawing it as a path.
+ * It's responsible for fetching the latest peaks and drawing them, one column per pixel.
  * @param g The JUCE graphics context used for all drawing operations.
  */
 void WaveformVisualizer::paint(juce::Graphics& g)
@@ -27,31 +27,52 @@ void WaveformVisualizer::paint(juce::Graphics& g)
     g.fillRoundedRectangle(bounds, 5.0f);
 
     // 2. Get the audio data.
-    // We ask our queue for the latest buffer of audio samples.
-    auto audioBuffer = audioBufferQueue.getBuffer();
-    // If the buffer is empty (e.g., no audio is playing), we stop here to avoid errors.
-    if (audioBuffer.getNumSamples() == 0) return;
+    // One min/max range per pixel column, from the queue's peak pyramid. This neither locks nor allocates.
+    drawnGeneration = audioBufferQueue.getTotalWritten();
+    // If nothing has been written yet (e.g., the host never started playback), we stop here.
+    if (drawnGeneration == 0 || columns.empty()) return;
 
-    // 3. Prepare to draw the waveform path.
-    g.setColour(juce::Colours::orange);
-    juce::Path path;
-    // We start drawing from the left edge, at the vertical center of our bounds.
-    path.startNewSubPath(bounds.getX(), bounds.getCentreY());
+    const auto numColumns = juce::jmin((int) columns.size(), (int) bounds.getWidth());
+    audioBufferQueue.getPeaks(0, drawnGeneration, displaySamples, columns.data(), numColumns);
 
-    // Get a direct pointer to the audio data for the first channel.
-    const float* channelData = audioBuffer.getReadPointer(0);
-    int numSamples = audioBuffer.getNumSamples();
+    // 3. Draw every column as a vertical line from its minimum to its maximum. Each column
+    // also reaches the previous one, so the waveform stays connected when zoomed in.
+    g.setColour(juce::Colours::orange);
+    auto previous = columns[0];
 
-    // 4. Loop through the audio samples and build the path.
-    for (int i = 0; i < numSamples; ++i)
+    for (int x = 0; x < numColumns; ++x)
     {
-        float x = juce::jmap((float)i, 0.0f, (float)numSamples - 1.0f, bounds.getX(), bounds.getRight());
-        float y = juce::jmap(channelData[i], -1.0f, 1.0f, bounds.getBottom(), bounds.getY());
-        path.lineTo(x, y);
+        const auto& column = columns[(size_t) x];
+        const auto low = juce::jmin(column.getStart(), previous.getEnd());
+        const auto high = juce::jmax(column.getEnd(), previous.getStart());
+        previous = column;
+
+        const auto top = juce::jmap(juce::jlimit(-1.0f, 1.0f, high), -1.0f, 1.0f, bounds.getBottom(), bounds.getY());
+        const auto bottom = juce::jmap(juce::jlimit(-1.0f, 1.0f, low), -1.0f, 1.0f, bounds.getBottom(), bounds.getY());
+        g.fillRect(bounds.getX() + (float) x, top - 1.0f, 2.0f, bottom - top + 2.0f);
     }
+}
 
-    // 5. Draw the completed path onto the screen.
-    g.strokePath(path, juce::PathStrokeType(2.0f));
+void WaveformVisualizer::resized()
+{
+    columns.assign((size_t) juce::jmax(1, getWidth()), {});
+    repaint();
+}
+
+void WaveformVisualizer::mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails& wheel)
+{
+    // Up zooms in (fewer samples), down zooms out, in powers of two.
+    if (wheel.deltaY > 0.0f)
+        displaySamples = juce::jmax(minDisplaySamples, displaySamples / 2);
+    else if (wheel.deltaY < 0.0f)
+        displaySamples = juce::jmin(maxDisplaySamples, displaySamples * 2);
+
+    repaint();
+}
+
+void WaveformVisualizer::timerCallback()
+{
+    // Only redraw when the audio thread has published something new.
+    if (audioBufferQueue.getTotalWritten() != drawnGeneration)
+        repaint();
 }
-    
-void WaveformVisualizer::timerCallback() { repaint(); }
\ No newline at end of file
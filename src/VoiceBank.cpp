@@ -0,0 +1,454 @@
+#include "VoiceBank.hpp"
+
+namespace
+{
+    /// @brief An envelope target that can never be reached, used for stages that hold their level.
+    constexpr float unreachableTarget = 2.0f;
+
+    /// @brief The golden ratio's fraction, which spreads the start phases of a stack without any repeating.
+    constexpr float phaseSpread = 0.618034f;
+
+    /// @brief The note at which keytracking leaves the voice cutoff where it is: middle C.
+    constexpr float keytrackCentre = 261.6256f;
+}
+
+VoiceBank::VoiceBank()
+{
+    // Idle lanes still get read by the vector code, so they need a valid table and a neutral envelope.
+    for (int v = 0; v < maxVoices; ++v)
+    {
+        table[(size_t) v] = wavetables->getTable(0, 0.0f);
+        setSegment(v, idle, 0.0f, unreachableTarget);
+    }
+}
+
+void VoiceBank::prepare(double newSampleRate, int newMaximumBlockSize)
+{
+    sampleRate = newSampleRate;
+    maximumBlockSize = juce::jmax(1, newMaximumBlockSize);
+    laneMix.assign((size_t) maximumBlockSize, Vec::expand(0.0f));
+    groupMix.assign((size_t) (maximumBlockSize * maxGroups), Vec::expand(0.0f));
+
+    // "Blaster" changes glide over 50 ms. Pitch bends arrive in steps, which a short ramp hides.
+    glideLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.05));
+    bendLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.005));
+    pitchRamp.assign((size_t) (maximumBlockSize * (maxLayers + 1)), 1.0f);
+    blasterRamp = {};
+    bendRamps.fill({});
+
+    for (int v = 0; v < maxVoices; ++v)
+        killVoice(v);
+}
+
+void VoiceBank::beginBlock(const ParameterSnapshot& snapshot) noexcept
+{
+    const auto sr = (float) sampleRate;
+
+    // Continuously update the target pitch based on the "Blaster" slider.
+    blasterRamp.setTarget(std::exp2(snapshot.pitch / 12.0f), glideLength);
+
+    // Nothing can be heard gliding while no voice sounds, so the next note starts at the new pitch.
+    if (std::none_of(activeVoicesInGroup.begin(), activeVoicesInGroup.end(), [](int count) { return count > 0; }))
+    {
+        blasterRamp.skip();
+        for (auto& ramp : bendRamps)
+            ramp.skip();
+    }
+
+    for (int l = 0; l < numLayers; ++l)
+    {
+        const auto& params = snapshot.layers[(size_t) l];
+        auto& settings = layerSettings[(size_t) l];
+
+        // Same linear rates as juce::ADSR.
+        settings.attackRate = 1.0f / (params.attack * sr);
+        settings.decayRate = (1.0f - params.sustain) / (params.decay * sr);
+        settings.sustainLevel = params.sustain;
+        settings.releaseSeconds = params.release;
+        settings.wave = params.wave;
+
+        // The oscillators are spread evenly over the detune range, the middle one(s) closest to the note.
+        settings.unison = juce::jlimit(1, maxUnison, params.unison);
+        settings.unisonGain = 1.0f / std::sqrt((float) settings.unison);
+        for (int u = 0; u < settings.unison; ++u)
+        {
+            const auto position = settings.unison > 1 ? (float) u / (float) (settings.unison - 1) - 0.5f : 0.0f;
+            settings.detuneRatio[(size_t) u] = std::exp2(position * params.unisonDetune / 1200.0f);
+        }
+
+        settings.voiceFilter = params.voiceCutoff < voiceFilterOpen;
+        settings.voiceCutoff = params.voiceCutoff;
+        settings.voiceKeytrack = params.voiceKeytrack;
+        settings.voiceEnvAmount = params.voiceEnvAmount;
+        settings.voiceDamping = 1.0f / params.voiceResonance;
+        settings.voiceEnvDecayPerSample = -1.0f / (params.voiceEnvDecay * sr);
+
+        settings.tableRatio = blasterRamp.getHighest() * bendRamps[(size_t) l].getHighest();
+    }
+
+    for (int v = 0; v < maxVoices; ++v)
+    {
+        const auto i = (size_t) v;
+        const auto& settings = layerSettings[(size_t) getLayerOfVoice(v)];
+
+        switch (stage[i])
+        {
+            case idle:    continue;
+            case attack:  envRate[i] = settings.attackRate; break;
+            case decay:   setSegment(v, decay, -settings.decayRate, settings.sustainLevel); break;
+            case sustain: envLevel[i] = settings.sustainLevel; break; // Sustain changes apply live, like juce::ADSR.
+            default:      break;
+        }
+
+        updateOscillators(v);
+        voiceCutoff[i] = getKeytrackedCutoff(v);
+    }
+}
+
+float VoiceBank::getKeytrackedCutoff(int voice) const noexcept
+{
+    const auto& settings = layerSettings[(size_t) getLayerOfVoice(voice)];
+    return settings.voiceCutoff * std::pow(noteFrequency[(size_t) voice] / keytrackCentre, settings.voiceKeytrack);
+}
+
+void VoiceBank::updateOscillators(int voice) noexcept
+{
+    const auto i = (size_t) voice;
+    const auto& settings = layerSettings[(size_t) getLayerOfVoice(voice)];
+
+    for (int u = 0; u < settings.unison; ++u)
+        unisonIncrement[(size_t) u][i] = increment[i] * settings.detuneRatio[(size_t) u];
+
+    // Pointer swap only; also moves to a table with fewer harmonics as the pitch rises.
+    // The highest oscillator of the stack at the highest pitch of the block picks it, so none of them can alias.
+    table[i] = wavetables->getTable(settings.wave, unisonIncrement[(size_t) settings.unison - 1][i] * settings.tableRatio);
+}
+
+void VoiceBank::setPitchBend(int layer, float semitones) noexcept
+{
+    bendRamps[(size_t) layer].setTarget(std::exp2(semitones / 12.0f), bendLength);
+}
+
+void VoiceBank::startVoice(int voice, int midiNoteNumber, float velocity) noexcept
+{
+    if (maximumBlockSize == 0) return;
+
+    const auto i = (size_t) voice;
+    const auto& settings = layerSettings[(size_t) getLayerOfVoice(voice)];
+
+    if (stage[i] == idle)
+        ++activeVoicesInGroup[i / (size_t) laneWidth];
+
+    // Convert the incoming MIDI note number (e.g., 69) to a frequency in Hz (e.g., 440).
+    noteFrequency[i] = (float) juce::MidiMessage::getMidiNoteInHertz(midiNoteNumber);
+    // The pitch ramps apply while rendering, so a new note joins a running glide where it is, without a "slide up".
+    increment[i] = noteFrequency[i] / (float) sampleRate;
+    updateOscillators(voice);
+    // Every note starts at the beginning of the cycle. The other oscillators of a stack start spread
+    // over the cycle, so they don't all add up into one loud click at the start of the note.
+    for (int u = 0; u < maxUnison; ++u)
+    {
+        const auto start = (float) u * phaseSpread;
+        unisonPhase[(size_t) u][i] = start - std::floor(start);
+    }
+
+    // The note's volume is determined by its MIDI velocity.
+    level[i] = velocity * 0.15f;
+
+    // The voice filter starts from silence, with its envelope fully open.
+    voiceCutoff[i] = getKeytrackedCutoff(voice);
+    filterEnv[i] = 1.0f;
+    filterState1[i] = 0.0f;
+    filterState2[i] = 0.0f;
+
+    // Trigger the "note on" phase of the envelope.
+    envLevel[i] = 0.0f;
+    setSegment(voice, attack, settings.attackRate, 1.0f);
+}
+
+void VoiceBank::releaseVoice(int voice) noexcept
+{
+    const auto i = (size_t) voice;
+    if (stage[i] == idle) return;
+
+    // Like juce::ADSR, the release ramp starts from wherever the envelope currently is.
+    const auto releaseSeconds = layerSettings[(size_t) getLayerOfVoice(voice)].releaseSeconds;
+    const auto rate = envLevel[i] / (releaseSeconds * (float) sampleRate);
+    setSegment(voice, release, -rate, 0.0f);
+}
+
+void VoiceBank::killVoice(int voice) noexcept
+{
+    const auto i = (size_t) voice;
+
+    if (stage[i] != idle)
+        --activeVoicesInGroup[i / (size_t) laneWidth];
+
+    envLevel[i] = 0.0f;
+    level[i] = 0.0f;
+    increment[i] = 0.0f;
+    for (auto& oscillator : unisonIncrement)
+        oscillator[i] = 0.0f;
+    filterState1[i] = 0.0f;
+    filterState2[i] = 0.0f;
+    setSegment(voice, idle, 0.0f, unreachableTarget);
+}
+
+void VoiceBank::setSegment(int voice, EnvelopeStage newStage, float rate, float target) noexcept
+{
+    const auto i = (size_t) voice;
+    stage[i] = newStage;
+    envRate[i] = rate;
+    envTarget[i] = target;
+    // A segment ends once (level - target) * direction >= 0. Holding stages use an
+    // upward direction with an unreachable target, so they never end on their own.
+    envDirection[i] = rate < 0.0f ? -1.0f : 1.0f;
+}
+
+void VoiceBank::advanceStage(int voice) noexcept
+{
+    const auto i = (size_t) voice;
+    const auto& settings = layerSettings[(size_t) getLayerOfVoice(voice)];
+    envLevel[i] = envTarget[i];
+
+    switch (stage[i])
+    {
+        case attack:  setSegment(voice, decay, -settings.decayRate, settings.sustainLevel); break;
+        case decay:   setSegment(voice, sustain, 0.0f, unreachableTarget); break;
+        case release: killVoice(voice); break;
+        default:      break;
+    }
+}
+
+void VoiceBank::render(float* const* layerMix, int numSamples) noexcept
+{
+    // Hosts may send larger blocks than announced, so render in chunks that fit laneMix.
+    for (int offset = 0; offset < numSamples;)
+    {
+        const auto chunk = juce::jmin(numSamples - offset, maximumBlockSize);
+
+        int numActiveGroups = 0;
+        for (int g = 0; g < maxGroups; ++g)
+            if (isGroupActive(g))
+                activeGroups[(size_t) numActiveGroups++] = g;
+
+        if (numActiveGroups == 0)
+            return;
+
+        // Write out the pitch ramps of the chunk: one row per layer, the blaster glide times that layer's bend.
+        auto* blaster = pitchRamp.data() + (size_t) (maxLayers * maximumBlockSize);
+        blasterRamp.fill(blaster, chunk);
+        for (int l = 0; l < numLayers; ++l)
+        {
+            auto* ratio = pitchRamp.data() + (size_t) (l * maximumBlockSize);
+            bendRamps[(size_t) l].fill(ratio, chunk);
+            juce::FloatVectorOperations::multiply(ratio, blaster, chunk);
+        }
+
+        // Every group gets its own scratch mix, so the workers never share memory.
+        const auto useWorkers = pool != nullptr && pool->getNumWorkers() > 0 && numActiveGroups > 1;
+        if (useWorkers)
+        {
+            chunkSize = chunk;
+            pool->run(numActiveGroups, &VoiceBank::renderGroupTask, this);
+        }
+
+        // A layer owns consecutive groups, so its active groups are one run of activeGroups.
+        const auto zero = Vec::expand(0.0f);
+        for (int first = 0; first < numActiveGroups;)
+        {
+            const auto layer = getLayerOfGroup(activeGroups[(size_t) first]);
+            auto last = first + 1;
+            while (last < numActiveGroups && getLayerOfGroup(activeGroups[(size_t) last]) == layer)
+                ++last;
+
+            std::fill(laneMix.begin(), laneMix.begin() + chunk, zero);
+
+            // Add the groups up in ascending order, in both paths, so the worker threads don't change the result.
+            for (int t = first; t < last; ++t)
+            {
+                if (useWorkers)
+                {
+                    const auto* scratch = groupMix.data() + (size_t) (t * maximumBlockSize);
+                    for (int s = 0; s < chunk; ++s)
+                        laneMix[(size_t) s] += scratch[s];
+                }
+                else
+                {
+                    renderGroup(activeGroups[(size_t) t], chunk, laneMix.data());
+                }
+            }
+
+            // One horizontal sum per sample and layer, no matter how many voices are sounding.
+            auto* mix = layerMix[layer] + offset;
+            for (int s = 0; s < chunk; ++s)
+                mix[s] += laneMix[(size_t) s].sum();
+
+            first = last;
+        }
+
+        offset += chunk;
+    }
+}
+
+void VoiceBank::renderGroupTask(void* context, int taskIndex) noexcept
+{
+    auto& bank = *static_cast<VoiceBank*>(context);
+    auto* scratch = bank.groupMix.data() + (size_t) (taskIndex * bank.maximumBlockSize);
+
+    std::fill(scratch, scratch + bank.chunkSize, Vec::expand(0.0f));
+    bank.renderGroup(bank.activeGroups[(size_t) taskIndex], bank.chunkSize, scratch);
+}
+
+void VoiceBank::updateFilterCoefficients(int group, int numSamples) noexcept
+{
+    const auto base = group * laneWidth;
+    const auto& settings = layerSettings[(size_t) getLayerOfGroup(group)];
+    const auto sr = (float) sampleRate;
+    const auto maxCutoff = 0.49f * sr;
+    const auto envDecay = std::exp(settings.voiceEnvDecayPerSample * (float) numSamples);
+
+    for (int v = base; v < base + laneWidth; ++v)
+    {
+        const auto i = (size_t) v;
+
+        // Idle lanes get a filter that just holds its state, which their zero envelope silences anyway.
+        if (stage[i] == idle)
+        {
+            filterA1[i] = 1.0f;
+            filterA2[i] = 0.0f;
+            filterA3[i] = 0.0f;
+            continue;
+        }
+
+        // The same coefficients as juce::dsp::StateVariableTPTFilter.
+        const auto cutoff = juce::jmin(voiceCutoff[i] * std::exp2(settings.voiceEnvAmount * filterEnv[i]), maxCutoff);
+        const auto g = std::tan(juce::MathConstants<float>::pi * cutoff / sr);
+        filterA1[i] = 1.0f / (1.0f + g * (g + settings.voiceDamping));
+        filterA2[i] = g * filterA1[i];
+        filterA3[i] = g * filterA2[i];
+
+        filterEnv[i] *= envDecay;
+    }
+}
+
+void VoiceBank::renderGroup(int group, int numSamples, Vec* mixTarget) noexcept
+{
+    const auto base = (size_t) (group * laneWidth);
+    const auto layer = getLayerOfGroup(group);
+    const auto& settings = layerSettings[(size_t) layer];
+    const auto numOscillators = settings.unison;
+    const auto filterOn = settings.voiceFilter;
+    const auto* pitchRatio = pitchRamp.data() + (size_t) (layer * maximumBlockSize);
+
+    // One register per oscillator of the stack, each holding that oscillator of every voice of the group.
+    Vec ph[maxUnison], inc[maxUnison];
+    for (int u = 0; u < numOscillators; ++u)
+    {
+        ph[u] = Vec::fromRawArray(unisonPhase[(size_t) u].data() + base);
+        inc[u] = Vec::fromRawArray(unisonIncrement[(size_t) u].data() + base);
+    }
+
+    // The stack's level correction is folded into the voice levels once, not applied per oscillator.
+    const auto gain = Vec::fromRawArray(level.data() + base) * settings.unisonGain;
+    auto env = Vec::fromRawArray(envLevel.data() + base);
+    auto rate = Vec::fromRawArray(envRate.data() + base);
+    auto target = Vec::fromRawArray(envTarget.data() + base);
+    auto direction = Vec::fromRawArray(envDirection.data() + base);
+
+    // The voice filters of the group: one lane per voice, like everything else.
+    auto ic1 = Vec::fromRawArray(filterState1.data() + base);
+    auto ic2 = Vec::fromRawArray(filterState2.data() + base);
+
+    const auto one = Vec::expand(1.0f);
+    const auto zero = Vec::expand(0.0f);
+    const auto* const* tables = table.data() + base;
+
+    alignas(64) float lanePhase[laneWidth];
+    alignas(64) float laneValue[laneWidth];
+    const auto cubic = highQuality.load(std::memory_order_relaxed);
+
+    for (int start = 0; start < numSamples; start += filterUpdateInterval)
+    {
+        const auto end = juce::jmin(numSamples, start + filterUpdateInterval);
+
+        // The cutoffs move with their envelopes at control rate; the filters themselves run every sample.
+        auto a1 = one, a2 = zero, a3 = zero;
+        if (filterOn)
+        {
+            updateFilterCoefficients(group, end - start);
+            a1 = Vec::fromRawArray(filterA1.data() + base);
+            a2 = Vec::fromRawArray(filterA2.data() + base);
+            a3 = Vec::fromRawArray(filterA3.data() + base);
+        }
+
+        for (int s = start; s < end; ++s)
+        {
+            auto oscillators = zero;
+            const auto pitch = Vec::expand(pitchRatio[s]);
+
+            for (int u = 0; u < numOscillators; ++u)
+            {
+                // The table reads are the only per-lane work: SIMD registers have no gather.
+                ph[u].copyToRawArray(lanePhase);
+                if (cubic)
+                {
+                    for (int l = 0; l < laneWidth; ++l)
+                        laneValue[l] = WavetableBank::lookupCubic(tables[l], lanePhase[l]);
+                }
+                else
+                {
+                    for (int l = 0; l < laneWidth; ++l)
+                        laneValue[l] = WavetableBank::lookup(tables[l], lanePhase[l]);
+                }
+
+                oscillators += Vec::fromRawArray(laneValue);
+
+                // Advance and wrap all phases of this oscillator at once, at this sample's pitch.
+                ph[u] += inc[u] * pitch;
+                ph[u] -= one & Vec::greaterThanOrEqual(ph[u], one);
+            }
+
+            // TPT state-variable low-pass (trapezoidal integrators), all voices of the group at once.
+            if (filterOn)
+            {
+                const auto v3 = oscillators - ic2;
+                const auto v1 = a1 * ic1 + a2 * v3;
+                const auto v2 = ic2 + a2 * ic1 + a3 * v3;
+                ic1 = v1 + v1 - ic1;
+                ic2 = v2 + v2 - ic2;
+                oscillators = v2;
+            }
+
+            mixTarget[s] += oscillators * env * gain;
+
+            // Advance all envelopes at once and look for lanes that reached the end of their segment.
+            env += rate;
+            const auto reached = Vec::greaterThanOrEqual((env - target) * direction, zero);
+
+            // Any set lane makes the sum non-zero (each set lane is 0xffffffff).
+            if (reached.sum() != 0)
+            {
+                env.copyToRawArray(envLevel.data() + base);
+
+                for (int l = 0; l < laneWidth; ++l)
+                {
+                    const auto v = base + (size_t) l;
+                    if (stage[v] != idle && (envLevel[v] - envTarget[v]) * envDirection[v] >= 0.0f)
+                        advanceStage((int) v);
+                }
+
+                env = Vec::fromRawArray(envLevel.data() + base);
+                rate = Vec::fromRawArray(envRate.data() + base);
+                target = Vec::fromRawArray(envTarget.data() + base);
+                direction = Vec::fromRawArray(envDirection.data() + base);
+            }
+        }
+    }
+
+    for (int u = 0; u < numOscillators; ++u)
+        ph[u].copyToRawArray(unisonPhase[(size_t) u].data() + base);
+    env.copyToRawArray(envLevel.data() + base);
+    ic1.copyToRawArray(filterState1.data() + base);
+    ic2.copyToRawArray(filterState2.data() + base);
+}
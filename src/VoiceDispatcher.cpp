@@ -0,0 +1,353 @@
+#include "VoiceDispatcher.hpp"
+#include <bit>
+#include <limits>
+
+VoiceDispatcher::VoiceDispatcher(VoiceBank& bank) : voiceBank(bank)
+{
+    for (int i = 0; i < maxVoices; ++i)
+        voices[(size_t) i].slot = i;
+
+    reset();
+}
+
+void VoiceDispatcher::reset() noexcept
+{
+    for (auto& voice : voices)
+    {
+        voiceBank.killVoice(voice.slot);
+        voice = SynthVoice { voice.slot };
+    }
+
+    freeMask.fill(~juce::uint64 {});
+    for (auto& layer : layers)
+    {
+        layer.activeHead = layer.activeTail = nullptr;
+        layer.numActiveVoices = 0;
+    }
+    numActiveVoices = 0;
+    sustainPedalDown.fill(false);
+}
+
+void VoiceDispatcher::setNumLayers(int newNumLayers) noexcept
+{
+    if (newNumLayers == voiceBank.getNumLayers())
+        return;
+
+    // Every voice has to be idle before the partitions move.
+    reset();
+    voiceBank.setNumLayers(newNumLayers);
+
+    for (auto& layer : layers)
+        layer.polyphony = juce::jmin(layer.polyphony, voiceBank.getVoicesPerLayer());
+}
+
+int VoiceDispatcher::getLayerOfChannel(int midiChannel) const noexcept
+{
+    const auto numLayers = voiceBank.getNumLayers();
+    if (numLayers == 1)
+        return 0;
+
+    return midiChannel <= numLayers ? midiChannel - 1 : -1;
+}
+
+void VoiceDispatcher::renderNextBlock(float* const* layerMix, const juce::MidiBuffer& midiMessages,
+                                      int startSample, int numSamples) noexcept
+{
+    const auto endSample = startSample + numSamples;
+    auto position = startSample;
+
+    // Only the events of this range: the processor may render one host block in several pieces.
+    for (auto it = midiMessages.findNextSamplePosition(startSample); it != midiMessages.cend(); ++it)
+    {
+        const auto metadata = *it;
+        if (metadata.samplePosition >= endSample)
+            break;
+
+        const auto eventPosition = juce::jmax(startSample, metadata.samplePosition);
+
+        // Only split the block where time actually moves on. Events on the same sample
+        // are applied back to back without a render call in between.
+        if (eventPosition > position)
+        {
+            renderSegment(layerMix, position - startSample, eventPosition - position);
+            position = eventPosition;
+        }
+
+        handleMidiEvent(metadata.data, metadata.numBytes);
+    }
+
+    if (endSample > position)
+        renderSegment(layerMix, position - startSample, endSample - position);
+}
+
+void VoiceDispatcher::renderSegment(float* const* layerMix, int offset, int numSamples) noexcept
+{
+    if (numActiveVoices == 0)
+        return;
+
+    // All layers render in the same pass over the bank.
+    std::array<float*, maxLayers> buses {};
+    for (int l = 0; l < voiceBank.getNumLayers(); ++l)
+        buses[(size_t) l] = layerMix[l] + offset;
+
+    voiceBank.render(buses.data(), numSamples);
+    retireFinishedVoices();
+}
+
+void VoiceDispatcher::handleMidiEvent(const juce::uint8* data, int numBytes) noexcept
+{
+    if (numBytes < 1)
+        return;
+
+    const auto status = data[0] & 0xf0;
+    const auto midiChannel = (data[0] & 0x0f) + 1;
+    const auto data1 = numBytes > 1 ? data[1] & 0x7f : 0;
+    const auto data2 = numBytes > 2 ? data[2] & 0x7f : 0;
+
+    switch (status)
+    {
+        case 0x90:
+            // A note-on with velocity 0 is a note-off.
+            if (data2 > 0)
+                noteOn(midiChannel, data1, (float) data2 / 127.0f);
+            else
+                noteOff(midiChannel, data1);
+            break;
+
+        case 0x80:
+            noteOff(midiChannel, data1);
+            break;
+
+        case 0xb0:
+            if (data1 == 64)
+                sustainPedal(midiChannel, data2 >= 64);
+            else if (data1 == 120) // All sound off
+                allNotesOff(midiChannel, false);
+            else if (data1 == 123) // All notes off
+                allNotesOff(midiChannel, true);
+            break;
+
+        case 0xe0:
+            pitchWheel(midiChannel, data1 | (data2 << 7));
+            break;
+
+        default:
+            break;
+    }
+}
+
+void VoiceDispatcher::noteOn(int midiChannel, int midiNoteNumber, float velocity) noexcept
+{
+    const auto layerIndex = getLayerOfChannel(midiChannel);
+    if (layerIndex < 0)
+        return;
+
+    auto& layer = layers[(size_t) layerIndex];
+
+    // Re-striking a note that is still held lets the old voice tail off through its release, and the
+    // new note gets a voice of its own, like juce::Synthesiser's stopVoice(voice, 1.0f, true).
+    // A hard cut here would click on every repeated note.
+    for (auto* voice = layer.activeHead; voice != nullptr; voice = voice->next)
+    {
+        if (voice->note == midiNoteNumber && voice->channel == midiChannel && (voice->keyDown || voice->sustained))
+        {
+            voice->keyDown = voice->sustained = false;
+            voiceBank.releaseVoice(voice->slot);
+        }
+    }
+
+    auto* voice = allocateVoice(layerIndex);
+
+    voice->note = midiNoteNumber;
+    voice->channel = midiChannel;
+    voice->keyDown = true;
+    voice->sustained = false;
+
+    // Append to the tail, so the list stays ordered from oldest to newest.
+    voice->previous = layer.activeTail;
+    voice->next = nullptr;
+    if (layer.activeTail != nullptr)
+        layer.activeTail->next = voice;
+    else
+        layer.activeHead = voice;
+    layer.activeTail = voice;
+    ++layer.numActiveVoices;
+    ++numActiveVoices;
+
+    voiceBank.startVoice(voice->slot, midiNoteNumber, velocity);
+}
+
+void VoiceDispatcher::noteOff(int midiChannel, int midiNoteNumber) noexcept
+{
+    const auto layerIndex = getLayerOfChannel(midiChannel);
+    if (layerIndex < 0)
+        return;
+
+    for (auto* voice = layers[(size_t) layerIndex].activeHead; voice != nullptr; voice = voice->next)
+    {
+        if (voice->note != midiNoteNumber || voice->channel != midiChannel || ! voice->keyDown)
+            continue;
+
+        voice->keyDown = false;
+
+        if (sustainPedalDown[(size_t) midiChannel])
+            voice->sustained = true;
+        else
+            voiceBank.releaseVoice(voice->slot);
+    }
+}
+
+void VoiceDispatcher::sustainPedal(int midiChannel, bool isDown) noexcept
+{
+    sustainPedalDown[(size_t) midiChannel] = isDown;
+
+    const auto layerIndex = getLayerOfChannel(midiChannel);
+    if (isDown || layerIndex < 0)
+        return;
+
+    for (auto* voice = layers[(size_t) layerIndex].activeHead; voice != nullptr; voice = voice->next)
+    {
+        if (voice->channel == midiChannel && voice->sustained)
+        {
+            voice->sustained = false;
+            voiceBank.releaseVoice(voice->slot);
+        }
+    }
+}
+
+void VoiceDispatcher::pitchWheel(int midiChannel, int wheelValue) noexcept
+{
+    const auto layerIndex = getLayerOfChannel(midiChannel);
+    if (layerIndex < 0)
+        return;
+
+    // 8192 is the centre of the 14-bit wheel.
+    voiceBank.setPitchBend(layerIndex, pitchBendRange * (float) (wheelValue - 8192) / 8192.0f);
+}
+
+void VoiceDispatcher::allNotesOff(int midiChannel, bool allowTailOff) noexcept
+{
+    const auto layerIndex = getLayerOfChannel(midiChannel);
+    if (layerIndex < 0)
+        return;
+
+    for (auto* voice = layers[(size_t) layerIndex].activeHead; voice != nullptr;)
+    {
+        auto* next = voice->next;
+
+        if (voice->channel == midiChannel)
+        {
+            voice->keyDown = false;
+            voice->sustained = false;
+
+            if (allowTailOff)
+            {
+                voiceBank.releaseVoice(voice->slot);
+            }
+            else
+            {
+                voiceBank.killVoice(voice->slot);
+                freeVoice(*voice);
+            }
+        }
+
+        voice = next;
+    }
+}
+
+SynthVoice* VoiceDispatcher::allocateVoice(int layerIndex) noexcept
+{
+    auto& layer = layers[(size_t) layerIndex];
+
+    if (layer.numActiveVoices >= layer.polyphony)
+    {
+        auto* victim = findVoiceToSteal(layer);
+        voiceBank.killVoice(victim->slot);
+        freeVoice(*victim);
+    }
+
+    // Take the lowest free slot of the layer's partition, which keeps its sounding voices in as few SIMD groups as possible.
+    const auto first = (size_t) (layerIndex * voiceBank.getVoicesPerLayer());
+    const auto end = first + (size_t) voiceBank.getVoicesPerLayer();
+
+    for (auto word = first / 64; word * 64 < end; ++word)
+    {
+        const auto low = juce::jmax(first, word * 64) - word * 64;
+        const auto high = juce::jmin(end, word * 64 + 64) - word * 64;
+        const auto partition = (high - low == 64 ? ~juce::uint64 {} : ((juce::uint64 { 1 } << (high - low)) - 1)) << low;
+
+        if (const auto available = freeMask[word] & partition; available != 0)
+        {
+            const auto bit = std::countr_zero(available);
+            freeMask[word] &= ~(juce::uint64 { 1 } << bit);
+            return &voices[word * 64 + (size_t) bit];
+        }
+    }
+
+    // Polyphony never exceeds the partition, so a slot is always free after stealing.
+    jassertfalse;
+    return layer.activeHead;
+}
+
+SynthVoice* VoiceDispatcher::findVoiceToSteal(const Layer& layer) const noexcept
+{
+    // Prefer the quietest voice that has already been released: it is on its way out anyway.
+    SynthVoice* quietestReleased = nullptr;
+    float quietestLevel = std::numeric_limits<float>::max();
+
+    for (auto* voice = layer.activeHead; voice != nullptr; voice = voice->next)
+    {
+        if (voice->keyDown || voice->sustained)
+            continue;
+
+        const auto amplitude = voiceBank.getVoiceAmplitude(voice->slot);
+        if (amplitude < quietestLevel)
+        {
+            quietestLevel = amplitude;
+            quietestReleased = voice;
+        }
+    }
+
+    // Otherwise the oldest voice, which is the head of the list.
+    return quietestReleased != nullptr ? quietestReleased : layer.activeHead;
+}
+
+void VoiceDispatcher::retireFinishedVoices() noexcept
+{
+    for (auto& layer : layers)
+    {
+        for (auto* voice = layer.activeHead; voice != nullptr;)
+        {
+            auto* next = voice->next;
+
+            if (voiceBank.isVoiceIdle(voice->slot))
+                freeVoice(*voice);
+
+            voice = next;
+        }
+    }
+}
+
+void VoiceDispatcher::freeVoice(SynthVoice& voice) noexcept
+{
+    auto& layer = getLayer(voice);
+
+    if (voice.previous != nullptr)
+        voice.previous->next = voice.next;
+    else
+        layer.activeHead = voice.next;
+
+    if (voice.next != nullptr)
+        voice.next->previous = voice.previous;
+    else
+        layer.activeTail = voice.previous;
+
+    voice.previous = voice.next = nullptr;
+    voice.note = -1;
+    voice.keyDown = voice.sustained = false;
+    --layer.numActiveVoices;
+    --numActiveVoices;
+
+    const auto slot = (size_t) voice.slot;
+    freeMask[slot / 64] |= juce::uint64 { 1 } << (slot % 64);
+}
@@ -0,0 +1,258 @@
+#include "VoiceRenderPool.hpp"
+#include <thread>
+
+/**
+ * @class VoiceRenderPool::Worker
+ * @brief A real-time thread that helps with the jobs of the pool, optionally pinned to one core.
+ */
+class VoiceRenderPool::Worker : public juce::Thread
+{
+public:
+    Worker(VoiceRenderPool& p, int queueIndex)
+        : juce::Thread("Cantina voice worker " + juce::String(queueIndex)), pool(p), queue(queueIndex)
+    {
+    }
+
+    ~Worker() override { stop(); }
+
+    void start()
+    {
+        startRealtimeThread(juce::Thread::RealtimeOptions{}.withPriority(8));
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        wake();
+        stopThread(1000);
+    }
+
+    /** @brief Wakes the worker if it has parked itself. Never locks. */
+    void wakeIfParked() noexcept
+    {
+        if (parked.load())
+            wake();
+    }
+
+    void run() override
+    {
+        const auto spinTicks = juce::Time::secondsToHighResolutionTicks(spinSeconds);
+        auto lastGeneration = pool.generation.load(std::memory_order_acquire);
+        auto lastWorkTime = juce::Time::getHighResolutionTicks();
+
+        while (! threadShouldExit())
+        {
+            updateAffinity();
+            const auto currentGeneration = pool.generation.load(std::memory_order_acquire);
+
+            if (currentGeneration != lastGeneration)
+            {
+                lastGeneration = currentGeneration;
+                pool.participate(queue, currentGeneration);
+                lastWorkTime = juce::Time::getHighResolutionTicks();
+                continue;
+            }
+
+            // Stay hot for a moment, which covers a worker that finished its tasks just before the
+            // others. Spinning across the gap between blocks would keep every worker core at 100%.
+            if (juce::Time::getHighResolutionTicks() - lastWorkTime < spinTicks)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // Sequentially consistent, so either we see the new generation or run() sees us parked.
+            // A wake-up between reading the counter and waiting makes the wait return at once.
+            const auto seenWakeUps = wakeUps.load();
+            parked.store(true);
+            if (pool.generation.load() == lastGeneration && ! threadShouldExit())
+                wakeUps.wait(seenWakeUps);
+            parked.store(false);
+            lastWorkTime = juce::Time::getHighResolutionTicks();
+        }
+    }
+
+private:
+    /** @brief Bumps the wake-up counter and wakes the worker if it is waiting on it. */
+    void wake() noexcept
+    {
+        wakeUps.fetch_add(1);
+        wakeUps.notify_one();
+    }
+
+    /** @brief Pins the worker to its own core or frees it again, whenever the pool's setting changed. */
+    void updateAffinity() noexcept
+    {
+        const auto shouldPin = pool.pinnedToCores.load(std::memory_order_relaxed);
+        if (shouldPin == pinned)
+            return;
+
+        pinned = shouldPin;
+        const auto numCores = juce::jlimit(1, 32, juce::SystemStats::getNumCpus());
+        const auto allCores = numCores == 32 ? ~juce::uint32 {} : (juce::uint32 { 1 } << numCores) - 1;
+
+        // Core 0 is left to the host's audio thread. Which core that really runs on is up to the
+        // host, which is why pinning is off while playing live.
+        const auto core = numCores > 1 ? 1 + (queue - 1) % (numCores - 1) : 0;
+        juce::Thread::setCurrentThreadAffinityMask(pinned ? juce::uint32 { 1 } << core : allCores);
+    }
+
+    /// @brief How long a worker keeps spinning after its last task before it parks.
+    static constexpr double spinSeconds = 0.0002;
+
+    VoiceRenderPool& pool;
+    const int queue;
+    /// @brief Bumped for every wake-up. Parked workers wait on it with std::atomic::wait, which is a
+    /// futex (Linux), __ulock (macOS) or WaitOnAddress (Windows): notifying takes no mutex.
+    std::atomic<juce::uint32> wakeUps { 0 };
+    std::atomic<bool> parked { false };
+    bool pinned = false;
+};
+
+VoiceRenderPool::VoiceRenderPool()
+{
+    for (auto& range : ranges)
+        range.store(pack(0, 0, 0), std::memory_order_relaxed);
+}
+
+VoiceRenderPool::~VoiceRenderPool()
+{
+    setNumWorkers(0);
+}
+
+void VoiceRenderPool::setNumWorkers(int numWorkers)
+{
+    numWorkers = juce::jlimit(0, maxWorkers, numWorkers);
+    const auto current = numRunningWorkers.load(std::memory_order_relaxed);
+
+    if (numWorkers == current)
+        return;
+
+    // Announce the new count first when shrinking, so no new job is split onto a stopping worker.
+    // Tasks already on its queue are stolen by the other participants. The Worker objects
+    // themselves stay alive, because the audio thread may still be looking at them.
+    if (numWorkers < current)
+        numRunningWorkers.store(numWorkers, std::memory_order_release);
+
+    for (int i = numWorkers; i < current; ++i)
+        workers[(size_t) i]->stop();
+
+    for (int i = current; i < numWorkers; ++i)
+    {
+        if (workers[(size_t) i] == nullptr)
+            workers[(size_t) i] = std::make_unique<Worker>(*this, i + 1);
+
+        workers[(size_t) i]->start();
+    }
+
+    numRunningWorkers.store(numWorkers, std::memory_order_release);
+}
+
+void VoiceRenderPool::run(int numTasks, TaskFunction function, void* context) noexcept
+{
+    if (numTasks <= 0)
+        return;
+
+    const auto workersNow = numRunningWorkers.load(std::memory_order_acquire);
+
+    // Nothing to share: run inline, in order.
+    if (workersNow == 0 || numTasks == 1)
+    {
+        for (int t = 0; t < numTasks; ++t)
+            function(context, t);
+        return;
+    }
+
+    const auto queues = juce::jmin(workersNow + 1, numTasks);
+    const auto tag = generation.load(std::memory_order_relaxed) + 1;
+
+    jobFunction.store(function, std::memory_order_relaxed);
+    jobContext.store(context, std::memory_order_relaxed);
+    tasksRemaining.store(numTasks, std::memory_order_relaxed);
+    numQueues.store(queues, std::memory_order_relaxed);
+
+    // Split the tasks into contiguous, evenly sized ranges, one per participant.
+    for (int q = 0; q <= maxWorkers; ++q)
+    {
+        const auto begin = (juce::uint32) (q < queues ? numTasks * q / queues : 0);
+        const auto end = (juce::uint32) (q < queues ? numTasks * (q + 1) / queues : 0);
+        ranges[(size_t) q].store(pack(tag, begin, end), std::memory_order_relaxed);
+    }
+
+    // Publishing the generation releases all of the above to the workers.
+    generation.store(tag);
+
+    for (int i = 0; i < workersNow; ++i)
+        if (auto* worker = workers[(size_t) i].get())
+            worker->wakeIfParked();
+
+    participate(0, tag);
+
+    // Only tasks that another participant is already running can be left.
+    while (tasksRemaining.load(std::memory_order_acquire) > 0)
+        std::this_thread::yield();
+}
+
+int VoiceRenderPool::popFront(int queue, juce::uint32 tag) noexcept
+{
+    auto& range = ranges[(size_t) queue];
+    auto current = range.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        const auto currentTag = (juce::uint32) (current >> 32);
+        const auto begin = (juce::uint32) ((current >> 16) & 0xffff);
+        const auto end = (juce::uint32) (current & 0xffff);
+
+        if (currentTag != tag || begin >= end)
+            return -1;
+
+        if (range.compare_exchange_weak(current, pack(tag, begin + 1, end), std::memory_order_acq_rel))
+            return (int) begin;
+    }
+}
+
+int VoiceRenderPool::stealBack(int queue, juce::uint32 tag) noexcept
+{
+    auto& range = ranges[(size_t) queue];
+    auto current = range.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        const auto currentTag = (juce::uint32) (current >> 32);
+        const auto begin = (juce::uint32) ((current >> 16) & 0xffff);
+        const auto end = (juce::uint32) (current & 0xffff);
+
+        if (currentTag != tag || begin >= end)
+            return -1;
+
+        if (range.compare_exchange_weak(current, pack(tag, begin, end - 1), std::memory_order_acq_rel))
+            return (int) end - 1;
+    }
+}
+
+void VoiceRenderPool::participate(int queue, juce::uint32 tag) noexcept
+{
+    const auto queues = numQueues.load(std::memory_order_relaxed);
+    const auto function = jobFunction.load(std::memory_order_relaxed);
+    auto* const context = jobContext.load(std::memory_order_relaxed);
+
+    auto execute = [&](int task)
+    {
+        function(context, task);
+        tasksRemaining.fetch_sub(1, std::memory_order_acq_rel);
+    };
+
+    // Own range first, front to back.
+    if (queue < queues)
+        for (int task = popFront(queue, tag); task >= 0; task = popFront(queue, tag))
+            execute(task);
+
+    // Then help the others, starting with the next participant.
+    for (int i = 1; i <= queues; ++i)
+    {
+        const auto victim = (queue + i) % queues;
+        for (int task = stealBack(victim, tag); task >= 0; task = stealBack(victim, tag))
+            execute(task);
+    }
+}
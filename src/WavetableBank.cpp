@@ -0,0 +1,72 @@
+#include "WavetableBank.hpp"
+
+namespace
+{
+    /// @brief One guard sample in front of every table and two behind it.
+    constexpr int stride = WavetableBank::tableSize + 3;
+}
+
+WavetableBank::WavetableBank()
+    : tables(static_cast<size_t>(numWaveforms * numTables * stride), 0.0f)
+{
+    // One full sine cycle. Every harmonic can be read from it with an integer index,
+    // which makes the additive synthesis below exact and cheap.
+    std::vector<float> sine(tableSize);
+    for (int i = 0; i < tableSize; ++i)
+        sine[(size_t) i] = (float) std::sin(juce::MathConstants<double>::twoPi * i / tableSize);
+
+    for (int t = 0; t < numTables; ++t)
+    {
+        const int numHarmonics = maxHarmonics >> t;
+
+        auto* sineTable = getTableData(0, t);
+        auto* sawTable = getTableData(1, t);
+        auto* squareTable = getTableData(2, t);
+
+        for (int i = 0; i < tableSize; ++i)
+        {
+            double saw = 0.0, square = 0.0;
+
+            for (int k = 1; k <= numHarmonics; ++k)
+            {
+                const auto partial = (double) sine[(size_t) ((k * i) % tableSize)] / k;
+                saw += partial;
+                if ((k & 1) != 0)
+                    square += partial;
+            }
+
+            sineTable[i] = sine[(size_t) i];
+            // Rising ramp from -1 to 1, like the original jmap(x, 0, 2pi, -1, 1) saw.
+            sawTable[i] = (float) (-2.0 / juce::MathConstants<double>::pi * saw);
+            // copysign(1, sin(x)) square.
+            squareTable[i] = (float) (4.0 / juce::MathConstants<double>::pi * square);
+        }
+
+        // Guard samples so lookup() and lookupCubic() never have to wrap.
+        for (auto* table : { sineTable, sawTable, squareTable })
+        {
+            table[-1] = table[tableSize - 1];
+            table[tableSize] = table[0];
+            table[tableSize + 1] = table[1];
+        }
+    }
+}
+
+const float* WavetableBank::getTable(int wave, float phaseIncrement) const noexcept
+{
+    wave = juce::jlimit(0, numWaveforms - 1, wave);
+
+    // Pick the richest table whose highest harmonic stays below Nyquist:
+    // maxHarmonics >> t must not exceed 0.5 / phaseIncrement.
+    const auto allowedHarmonics = 0.5f / juce::jmax(phaseIncrement, 1.0e-9f);
+    int t = 0;
+    while (t < numTables - 1 && (float) (maxHarmonics >> t) > allowedHarmonics)
+        ++t;
+
+    return tables.data() + (size_t) ((wave * numTables + t) * stride) + 1;
+}
+
+float* WavetableBank::getTableData(int wave, int tableIndex) noexcept
+{
+    return tables.data() + (size_t) ((wave * numTables + tableIndex) * stride) + 1;
+}
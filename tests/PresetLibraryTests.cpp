@@ -0,0 +1,196 @@
+#include "PluginProcessor.hpp"
+#include "PresetLibrary.hpp"
+
+#include <algorithm>
+
+/**
+ * @file PresetLibraryTests.cpp
+ * @brief Writes a user bank, reopens it through the memory mapping and checks the lookups and
+ *        applyPreset(), then damages the bank in the ways openBank() has to catch.
+ */
+
+namespace
+{
+    void setParameter(juce::AudioProcessorValueTreeState& apvts, const juce::String& parameterID, float value)
+    {
+        auto* param = apvts.getParameter(parameterID);
+        jassert(param != nullptr);
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+    }
+
+    float getParameter(juce::AudioProcessorValueTreeState& apvts, const juce::String& parameterID)
+    {
+        auto* param = apvts.getParameter(parameterID);
+        jassert(param != nullptr);
+        return param->convertFrom0to1(param->getValue());
+    }
+
+    std::vector<PresetLibrary::BankPreset> makePresets()
+    {
+        // DECAY is a column of the bank but "Moon Bass" leaves it alone, so its value is NaN.
+        return {
+            { "Moon Bass", "Bass", "dark, plucked",
+              { { "ATTACK", 0.05f }, { "FILTER_FREQ", 1500.0f }, { "REVERB_WET_LEVEL", 0.6f }, { "NOT_A_PARAMETER", 1.0f } } },
+            { "Glass Lead", "Lead", "bright,lead",
+              { { "ATTACK", 0.3f }, { "DECAY", 0.9f } } },
+            { "Night Pad", "Pads", "",
+              { { "SUSTAIN", 0.7f } } },
+        };
+    }
+
+    juce::uint32 readUInt(const juce::MemoryBlock& block, size_t offset)
+    {
+        return juce::ByteOrder::littleEndianInt(static_cast<const char*>(block.getData()) + offset);
+    }
+
+    void writeUInt(juce::MemoryBlock& block, size_t offset, juce::uint32 value)
+    {
+        const auto littleEndian = juce::ByteOrder::swapIfBigEndian(value);
+        block.copyFrom(&littleEndian, (int) offset, sizeof(littleEndian));
+    }
+}
+
+class PresetLibraryTests : public juce::UnitTest
+{
+public:
+    PresetLibraryTests()
+        : juce::UnitTest("PresetLibrary", "PresetLibrary")
+    {
+    }
+
+    void runTest() override
+    {
+        CantinaComposerAudioProcessor processor;
+        auto& apvts = processor.apvts;
+        PresetLibrary library(apvts);
+        const auto first = PresetLibrary::getNumFactoryPresets();
+
+        juce::TemporaryFile bankFile(".ccpb");
+        const auto presets = makePresets();
+
+        beginTest("A written bank reopens with every preset");
+        {
+            expect(PresetLibrary::writeBank(bankFile.getFile(), presets));
+            expect(library.openBank(bankFile.getFile()));
+            expectEquals(library.getNumPresets(), first + (int) presets.size());
+
+            for (int i = 0; i < (int) presets.size(); ++i)
+            {
+                const auto& preset = presets[(size_t) i];
+                expect(library.getName(first + i) == preset.name.toStdString());
+                expect(library.getCategory(first + i) == preset.category.toStdString());
+                expect(library.getTags(first + i) == preset.tags.toStdString());
+            }
+        }
+
+        beginTest("Name, category and tag lookups cover the factory presets and the bank");
+        {
+            expectEquals(library.findByName("Moon Bass"), first);
+            expectEquals(library.findByName("Night Pad"), first + 2);
+            expectEquals(library.findByName("Kloo Horn (Flute)"), 0);
+            expectEquals(library.findByName("Nothing"), -1);
+
+            const auto categories = library.getCategories();
+            expect(std::is_sorted(categories.begin(), categories.end()));
+            for (const auto* category : { "Bass", "Lead", "Pads", "Percussion", "Winds" })
+                expect(std::find(categories.begin(), categories.end(), category) != categories.end(), category);
+
+            expect(library.getPresetsInCategory("Bass") == std::vector<int> { first });
+            expect(library.getPresetsInCategory("Nothing").empty());
+
+            // Tags are trimmed, and a preset without tags is in no tag list.
+            expect(library.getPresetsWithTag("plucked") == std::vector<int> { 2, first });
+            expect(library.getPresetsWithTag("lead") == std::vector<int> { 0, 3, first + 1 });
+            expect(library.getPresetsWithTag("").empty());
+        }
+
+        beginTest("applyPreset sets the values of a bank preset");
+        {
+            setParameter(apvts, "DECAY", 0.5f);
+            expect(library.applyPreset(first));
+
+            expectWithinAbsoluteError(getParameter(apvts, "ATTACK"), 0.05f, 1.0e-3f);
+            expectWithinAbsoluteError(getParameter(apvts, "FILTER_FREQ"), 1500.0f, 1.0f);
+            expectWithinAbsoluteError(getParameter(apvts, "REVERB_WET_LEVEL"), 0.6f, 1.0e-4f);
+            expectWithinAbsoluteError(getParameter(apvts, "DECAY"), 0.5f, 1.0e-3f, "A NaN value changed the parameter");
+
+            expect(library.applyPreset(first + 1));
+            expectWithinAbsoluteError(getParameter(apvts, "DECAY"), 0.9f, 1.0e-3f);
+        }
+
+        beginTest("applyPreset on another layer only sets that layer's parameters");
+        {
+            setParameter(apvts, "REVERB_WET_LEVEL", 0.1f);
+            setParameter(apvts, "FILTER_FREQ", 8000.0f);
+            expect(library.applyPreset(first, 1));
+
+            expectWithinAbsoluteError(getParameter(apvts, InstrumentLayers::getParameterID("FILTER_FREQ", 1)), 1500.0f, 1.0f);
+            expectWithinAbsoluteError(getParameter(apvts, InstrumentLayers::getParameterID("ATTACK", 1)), 0.05f, 1.0e-3f);
+            expectWithinAbsoluteError(getParameter(apvts, "FILTER_FREQ"), 8000.0f, 1.0f);
+            expectWithinAbsoluteError(getParameter(apvts, "REVERB_WET_LEVEL"), 0.1f, 1.0e-4f);
+
+            expect(! library.applyPreset(-1));
+            expect(! library.applyPreset(library.getNumPresets()));
+            expect(! library.applyPreset(first, InstrumentLayers::maxLayers));
+        }
+
+        beginTest("Closing the bank leaves the factory presets");
+        {
+            library.closeBank();
+            expectEquals(library.getNumPresets(), first);
+            expectEquals(library.findByName("Moon Bass"), -1);
+            expect(library.getPresetsInCategory("Bass").empty());
+        }
+
+        beginTest("Damaged banks are rejected");
+        {
+            juce::MemoryBlock valid;
+            expect(bankFile.getFile().loadFileAsData(valid));
+
+            const auto recordsOffset = readUInt(valid, 20);
+            const auto stringsSize = readUInt(valid, 28);
+
+            juce::MemoryBlock truncated(valid.getData(), valid.getSize() - 4);
+            expectRejected(library, truncated, "a truncated bank");
+
+            juce::MemoryBlock headerOnly(valid.getData(), 16);
+            expectRejected(library, headerOnly, "a bank cut inside its header");
+
+            auto badVersion = valid;
+            writeUInt(badVersion, 4, 2);
+            expectRejected(library, badVersion, "a bank of another version");
+
+            auto badName = valid;
+            writeUInt(badName, recordsOffset, stringsSize);
+            expectRejected(library, badName, "a name offset past the strings");
+
+            auto badTags = valid;
+            writeUInt(badTags, recordsOffset + 8, 0xffffffffu);
+            expectRejected(library, badTags, "a tags offset past the strings");
+
+            auto badParameterID = valid;
+            writeUInt(badParameterID, readUInt(valid, 16), stringsSize + 100);
+            expectRejected(library, badParameterID, "a parameter ID offset past the strings");
+
+            auto badRecords = valid;
+            writeUInt(badRecords, 8, 1000000);
+            expectRejected(library, badRecords, "more records than the file holds");
+        }
+    }
+
+private:
+    void expectRejected(PresetLibrary& library, const juce::MemoryBlock& bank, const juce::String& what)
+    {
+        // A rejected bank must also close the one that was open before.
+        juce::TemporaryFile validFile(".ccpb"), damagedFile(".ccpb");
+        expect(PresetLibrary::writeBank(validFile.getFile(), makePresets()));
+        expect(library.openBank(validFile.getFile()));
+
+        expect(damagedFile.getFile().replaceWithData(bank.getData(), bank.getSize()));
+        expect(! library.openBank(damagedFile.getFile()), "Accepted " + what);
+        expectEquals(library.getNumPresets(), PresetLibrary::getNumFactoryPresets());
+        expectEquals(library.findByName("Moon Bass"), -1);
+    }
+};
+
+static PresetLibraryTests presetLibraryTests;
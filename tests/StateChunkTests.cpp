@@ -0,0 +1,182 @@
+#include "PluginProcessor.hpp"
+#include "StateChunk.hpp"
+
+#include <vector>
+
+/**
+ * @file StateChunkTests.cpp
+ * @brief Round trips of the binary host state, including the parts a host never exercises on purpose:
+ *        a changed parameter layout, a damaged chunk and a chunk from a newer version.
+ */
+
+namespace
+{
+    void setParameter(juce::AudioProcessorValueTreeState& apvts, const juce::String& parameterID, float value)
+    {
+        auto* param = apvts.getParameter(parameterID);
+        jassert(param != nullptr);
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+    }
+
+    float getParameter(juce::AudioProcessorValueTreeState& apvts, const juce::String& parameterID)
+    {
+        auto* param = apvts.getParameter(parameterID);
+        jassert(param != nullptr);
+        return param->convertFrom0to1(param->getValue());
+    }
+
+    /** @brief The normalised values of all parameters, in layout order. */
+    std::vector<float> getAllValues(juce::AudioProcessor& processor)
+    {
+        std::vector<float> values;
+        for (auto* parameter : processor.getParameters())
+            values.push_back(parameter->getValue());
+        return values;
+    }
+
+    /** @brief Moves every parameter away from its default, to a value that survives the parameter's snapping. */
+    void setAllToNonDefaults(juce::AudioProcessor& processor)
+    {
+        for (auto* parameter : processor.getParameters())
+            parameter->setValueNotifyingHost(parameter->getDefaultValue() < 0.5f ? 0.8f : 0.2f);
+    }
+
+    /** @brief Builds a chunk by hand, for layouts and versions this build would never write. */
+    juce::MemoryBlock makeChunk(juce::uint32 version, const std::vector<std::pair<juce::String, float>>& values)
+    {
+        juce::MemoryOutputStream out;
+        out.write("CCST", 4);
+        out.writeInt((int) version);
+        out.writeInt((int) values.size());
+
+        for (const auto& [id, value] : values)
+        {
+            out.writeInt((int) StateChunk::hashParameterID(id));
+            out.writeFloat(value);
+        }
+
+        return out.getMemoryBlock();
+    }
+}
+
+class StateChunkTests : public juce::UnitTest
+{
+public:
+    StateChunkTests()
+        : juce::UnitTest("StateChunk", "StateChunk")
+    {
+    }
+
+    void runTest() override
+    {
+        beginTest("A round trip restores every value");
+        {
+            CantinaComposerAudioProcessor source;
+            setAllToNonDefaults(source);
+            const auto expected = getAllValues(source);
+
+            juce::MemoryBlock state;
+            source.getStateInformation(state);
+            expect(StateChunk::isStateChunk(state.getData(), (int) state.getSize()));
+
+            CantinaComposerAudioProcessor target;
+            target.setStateInformation(state.getData(), (int) state.getSize());
+            expectValues(target, expected);
+        }
+
+        beginTest("A restored state survives prepareToPlay");
+        {
+            CantinaComposerAudioProcessor source;
+            setAllToNonDefaults(source);
+            const auto expected = getAllValues(source);
+
+            juce::MemoryBlock state;
+            source.getStateInformation(state);
+
+            // Hosts restore before they prepare, and prepare again on every rate or block size change.
+            CantinaComposerAudioProcessor target;
+            target.setStateInformation(state.getData(), (int) state.getSize());
+
+            target.setRateAndBufferSizeDetails(48000.0, 256);
+            target.prepareToPlay(48000.0, 256);
+            expectValues(target, expected);
+
+            target.setRateAndBufferSizeDetails(44100.0, 512);
+            target.prepareToPlay(44100.0, 512);
+            expectValues(target, expected);
+
+            target.releaseResources();
+        }
+
+        beginTest("A reordered chunk is matched by hash and missing parameters are reset");
+        {
+            CantinaComposerAudioProcessor processor;
+            auto& apvts = processor.apvts;
+            setParameter(apvts, "DECAY", 0.8f);
+            setParameter(apvts, "BASS_GAIN", 9.0f);
+
+            // Reversed against the layout, so no entry is where the fast path looks for it.
+            const auto chunk = makeChunk(StateChunk::currentVersion, { { "REVERB_WET_LEVEL", 0.25f },
+                                                                       { "FILTER_FREQ", 3000.0f },
+                                                                       { "ATTACK", 0.5f },
+                                                                       { "NOT_A_PARAMETER", 1.0f } });
+            StateChunk stateChunk(processor);
+            expect(stateChunk.read(chunk.getData(), (int) chunk.getSize()));
+
+            expectWithinAbsoluteError(getParameter(apvts, "REVERB_WET_LEVEL"), 0.25f, 1.0e-4f);
+            expectWithinAbsoluteError(getParameter(apvts, "FILTER_FREQ"), 3000.0f, 1.0f);
+            expectWithinAbsoluteError(getParameter(apvts, "ATTACK"), 0.5f, 1.0e-3f);
+
+            for (const auto* id : { "DECAY", "BASS_GAIN" })
+            {
+                auto* param = apvts.getParameter(id);
+                expectWithinAbsoluteError(param->getValue(), param->getDefaultValue(), 1.0e-6f, juce::String(id) + " was not reset");
+            }
+        }
+
+        beginTest("Truncated and future chunks are rejected without changing anything");
+        {
+            CantinaComposerAudioProcessor processor;
+            setAllToNonDefaults(processor);
+
+            juce::MemoryBlock valid;
+            processor.getStateInformation(valid);
+
+            // Restoring any of these would move every parameter back to 0.2/0.8 or to its default.
+            CantinaComposerAudioProcessor target;
+            const auto before = getAllValues(target);
+            StateChunk stateChunk(target);
+
+            juce::MemoryBlock truncated(valid.getData(), valid.getSize() - 3);
+            expect(! stateChunk.read(truncated.getData(), (int) truncated.getSize()), "A truncated chunk was accepted");
+            expectValues(target, before);
+
+            juce::MemoryBlock headerOnly(valid.getData(), 8);
+            expect(! stateChunk.read(headerOnly.getData(), (int) headerOnly.getSize()), "A chunk without a header was accepted");
+            expectValues(target, before);
+
+            auto future = valid;
+            const auto nextVersion = juce::ByteOrder::swapIfBigEndian(StateChunk::currentVersion + 1);
+            future.copyFrom(&nextVersion, 4, sizeof(nextVersion));
+            expect(! stateChunk.read(future.getData(), (int) future.getSize()), "A chunk of a newer version was accepted");
+            expectValues(target, before);
+
+            expect(stateChunk.read(valid.getData(), (int) valid.getSize()));
+            expectValues(target, getAllValues(processor));
+        }
+    }
+
+private:
+    void expectValues(juce::AudioProcessor& processor, const std::vector<float>& expected)
+    {
+        const auto values = getAllValues(processor);
+        expectEquals((int) values.size(), (int) expected.size());
+
+        const auto& parameters = processor.getParameters();
+        for (size_t i = 0; i < juce::jmin(values.size(), expected.size()); ++i)
+            expectWithinAbsoluteError(values[i], expected[i], 1.0e-5f,
+                                      "Parameter " + parameters[(int) i]->getName(64) + " differs");
+    }
+};
+
+static StateChunkTests stateChunkTests;
@@ -0,0 +1,51 @@
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+#include <cstdio>
+
+/**
+ * @file TestMain.cpp
+ * @brief Runs the unit tests registered by the files in tests/.
+ *
+ * Every test file registers a static juce::UnitTest instance under a category
+ * named after the class it covers, and CTest runs one category per test.
+ *
+ * Usage: CantinaComposerTests [--category <name>]
+ *   --category  Only runs the tests of this category (default: all of them).
+ *
+ * Exits with 1 if any test failed.
+ */
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::String category;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+
+        if (arg == "--category" && i + 1 < argc)
+            category = argv[++i];
+        else
+        {
+            std::printf("Usage: %s [--category <name>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+
+    if (category.isEmpty())
+        runner.runAllTests();
+    else
+        runner.runTestsInCategory(category);
+
+    int numFailures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        numFailures += runner.getResult(i)->failures;
+
+    return numFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,283 @@
+#include "PluginProcessor.hpp"
+#include "DspProfiler.hpp"
+
+#include <cstdio>
+#include <vector>
+
+/**
+ * @file Benchmark.cpp
+ * @brief Headless throughput benchmark for the full processBlock chain.
+ *
+ * Creates a CantinaComposerAudioProcessor without an editor, drives it with
+ * generated MIDI and reports ns/sample and realtime factor for every stage.
+ *
+ * Usage: CantinaComposerBenchmark [--seconds <n>] [--full] [--csv] [--offline] [--state]
+ *   --seconds  Audio seconds rendered per configuration (default 4).
+ *   --full     Sweep the full cartesian product instead of one axis at a time.
+ *   --csv      Print comma separated values instead of an aligned table.
+ *   --offline  Render like a host bounce (setNonRealtime), with the offline strategy. The oversampling
+ *              is not swept then: a bounce always runs at 8x, and the "os" column says so.
+ *   --state    Time saving and loading the host state (binary chunk and legacy XML) instead.
+ */
+
+namespace
+{
+    struct BenchmarkConfig
+    {
+        int numVoices = 8;
+        int blockSize = 512;
+        double sampleRate = 48000.0;
+        int wave = 1;
+        float gobblerAmount = 0.5f;
+        float reverbWetLevel = 0.33f;
+        bool multiCore = false;
+        int oversampling = 0;
+    };
+
+    struct BenchmarkResult
+    {
+        double audioSeconds = 0.0;
+        double stageSeconds[DspProfiler::numStages] {};
+        double totalSeconds = 0.0;
+    };
+
+    const char* waveNames[] = { "Sine", "Saw", "Square" };
+
+    void setParameter(juce::AudioProcessorValueTreeState& apvts, const juce::String& parameterID, float value)
+    {
+        auto* param = apvts.getParameter(parameterID);
+        jassert(param != nullptr);
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+    }
+
+    /** @brief Renders one configuration and returns the accumulated stage timings. */
+    BenchmarkResult runConfig(const BenchmarkConfig& config, double secondsToRender, bool offline)
+    {
+        CantinaComposerAudioProcessor processor;
+        DspProfiler profiler;
+
+        // Hosts switch to non-realtime before preparing for a bounce.
+        processor.setNonRealtime(offline);
+
+        auto& apvts = processor.apvts;
+
+        // There is no message loop here to start the worker threads asynchronously,
+        // so this has to be set before prepareToPlay picks it up.
+        setParameter(apvts, "MULTICORE", config.multiCore ? 1.0f : 0.0f);
+        setParameter(apvts, "POLYPHONY", static_cast<float>(config.numVoices));
+        setParameter(apvts, "OVERSAMPLING", static_cast<float>(config.oversampling));
+
+        processor.setRateAndBufferSizeDetails(config.sampleRate, config.blockSize);
+        processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+        // Our settings go on top of the preset the fresh instance started with.
+        setParameter(apvts, "WAVE", static_cast<float>(config.wave));
+        setParameter(apvts, "JIZZ_GOBBLER_AMOUNT", config.gobblerAmount);
+        setParameter(apvts, "REVERB_WET_LEVEL", config.reverbWetLevel);
+
+        juce::AudioBuffer<float> buffer(processor.getTotalNumOutputChannels(), config.blockSize);
+        juce::MidiBuffer midi;
+
+        // A chord of numVoices notes, released and re-struck once per second so
+        // the envelopes and the voice allocation are part of the measurement.
+        const auto retriggerBlocks = juce::jmax(2, static_cast<int>(config.sampleRate / config.blockSize));
+        const auto warmupBlocks = retriggerBlocks / 2;
+        const auto measuredBlocks = juce::jmax(1, static_cast<int>(secondsToRender * config.sampleRate / config.blockSize));
+
+        auto renderBlock = [&](int blockIndex)
+        {
+            midi.clear();
+            const auto phase = blockIndex % retriggerBlocks;
+
+            for (int v = 0; v < config.numVoices; ++v)
+            {
+                // Spread large chords over a second channel, so every note stays distinct.
+                const auto channel = 1 + v / 96;
+                const auto note = 24 + v % 96;
+                if (phase == 0)
+                    midi.addEvent(juce::MidiMessage::noteOn(channel, note, 0.8f), 0);
+                else if (phase == retriggerBlocks - 1)
+                    midi.addEvent(juce::MidiMessage::noteOff(channel, note), config.blockSize - 1);
+            }
+
+            processor.processBlock(buffer, midi);
+        };
+
+        for (int i = 0; i < warmupBlocks; ++i)
+            renderBlock(i);
+
+        processor.setProfiler(&profiler);
+        for (int i = 0; i < measuredBlocks; ++i)
+            renderBlock(warmupBlocks + i);
+        processor.setProfiler(nullptr);
+
+        processor.releaseResources();
+
+        BenchmarkResult result;
+        result.audioSeconds = static_cast<double>(profiler.getNumSamples()) / config.sampleRate;
+        for (int s = 0; s < DspProfiler::numStages; ++s)
+            result.stageSeconds[s] = profiler.getSeconds(static_cast<DspProfiler::Stage>(s));
+        result.totalSeconds = profiler.getTotalSeconds();
+        return result;
+    }
+
+    /** @brief Times get/setStateInformation for the binary chunk and for the legacy XML state. */
+    void runStateBenchmark(bool csv)
+    {
+        constexpr int iterations = 10000;
+
+        CantinaComposerAudioProcessor processor;
+
+        juce::MemoryBlock binaryState, xmlState, destination;
+        processor.getStateInformation(binaryState);
+        if (auto xml = processor.apvts.copyState().createXml())
+            juce::AudioProcessor::copyXmlToBinary(*xml, xmlState);
+
+        auto microsPerCall = [](auto&& call)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            for (int i = 0; i < iterations; ++i)
+                call();
+            const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+            return seconds * 1.0e6 / iterations;
+        };
+
+        // The XML save is what getStateInformation did before the binary chunk.
+        const auto binarySave = microsPerCall([&] { processor.getStateInformation(destination); });
+        const auto binaryLoad = microsPerCall([&] { processor.setStateInformation(binaryState.getData(), (int) binaryState.getSize()); });
+        const auto xmlSave = microsPerCall([&]
+        {
+            if (auto xml = processor.apvts.copyState().createXml())
+                juce::AudioProcessor::copyXmlToBinary(*xml, destination);
+        });
+        const auto xmlLoad = microsPerCall([&] { processor.setStateInformation(xmlState.getData(), (int) xmlState.getSize()); });
+
+        if (csv)
+            std::printf("format,bytes,save_us,load_us\n");
+        else
+            std::printf("%-8s %8s %10s %10s\n", "format", "bytes", "save us", "load us");
+
+        const char* lineFormat = csv ? "%s,%d,%.3f,%.3f\n" : "%-8s %8d %10.3f %10.3f\n";
+        std::printf(lineFormat, "binary", (int) binaryState.getSize(), binarySave, binaryLoad);
+        std::printf(lineFormat, "xml", (int) xmlState.getSize(), xmlSave, xmlLoad);
+    }
+
+    void printHeader(bool csv)
+    {
+        if (csv)
+        {
+            std::printf("voices,block,rate,wave,gobbler,reverb,multicore,oversampling,stage,ns_per_sample,realtime_factor\n");
+            return;
+        }
+
+        std::printf("%6s %6s %8s %7s %8s %7s %3s %3s  %-12s %12s %14s\n",
+                    "voices", "block", "rate", "wave", "gobbler", "reverb", "mc", "os", "stage", "ns/sample", "realtime x");
+    }
+
+    void printResult(const BenchmarkConfig& config, const BenchmarkResult& result, bool csv)
+    {
+        const auto numSamples = result.audioSeconds * config.sampleRate;
+
+        auto printLine = [&](const char* stageName, double seconds)
+        {
+            const auto nsPerSample = numSamples > 0.0 ? seconds * 1.0e9 / numSamples : 0.0;
+            const auto realtimeFactor = seconds > 0.0 ? result.audioSeconds / seconds : 0.0;
+
+            std::printf(csv ? "%d,%d,%.0f,%s,%.2f,%.2f,%d,%d,%s,%.3f,%.1f\n"
+                            : "%6d %6d %8.0f %7s %8.2f %7.2f %3d %3d  %-12s %12.3f %14.1f\n",
+                        config.numVoices, config.blockSize, config.sampleRate, waveNames[config.wave],
+                        config.gobblerAmount, config.reverbWetLevel, config.multiCore ? 1 : 0,
+                        1 << config.oversampling, stageName, nsPerSample, realtimeFactor);
+        };
+
+        for (int s = 0; s < DspProfiler::numStages; ++s)
+            printLine(DspProfiler::getStageName(static_cast<DspProfiler::Stage>(s)), result.stageSeconds[s]);
+
+        printLine("total", result.totalSeconds);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    double secondsToRender = 4.0;
+    bool fullSweep = false, csv = false, offline = false, stateOnly = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+
+        if (arg == "--seconds" && i + 1 < argc)
+            secondsToRender = juce::jmax(0.1, juce::String(argv[++i]).getDoubleValue());
+        else if (arg == "--full")
+            fullSweep = true;
+        else if (arg == "--csv")
+            csv = true;
+        else if (arg == "--offline")
+            offline = true;
+        else if (arg == "--state")
+            stateOnly = true;
+        else
+        {
+            std::printf("Usage: %s [--seconds <n>] [--full] [--csv] [--offline] [--state]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (stateOnly)
+    {
+        runStateBenchmark(csv);
+        return 0;
+    }
+
+    const std::vector<int> voiceCounts { 1, 2, 4, 8, 16, 32, 64, 128 };
+    const std::vector<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048 };
+    const std::vector<double> sampleRates { 44100.0, 48000.0, 96000.0, 192000.0 };
+    const std::vector<int> waves { 0, 1, 2 };
+    const std::vector<float> gobblerAmounts { 0.0f, 0.5f, 1.0f };
+    const std::vector<float> reverbWetLevels { 0.0f, 0.33f, 1.0f };
+    const std::vector<bool> multiCoreModes { false, true };
+    // A bounce always runs the distortion at 8x, whatever "OVERSAMPLING" says. Sweeping the choice
+    // would time the same thing four times and print factors that never ran.
+    const auto offlineOversampling = 3;
+    const auto oversamplingChoices = offline ? std::vector<int> { offlineOversampling } : std::vector<int> { 0, 1, 2, 3 };
+
+    std::vector<BenchmarkConfig> configs;
+    BenchmarkConfig baseline;
+    if (offline)
+        baseline.oversampling = offlineOversampling;
+
+    if (fullSweep)
+    {
+        for (auto voices : voiceCounts)
+            for (auto block : blockSizes)
+                for (auto rate : sampleRates)
+                    for (auto wave : waves)
+                        for (auto gobbler : gobblerAmounts)
+                            for (auto wet : reverbWetLevels)
+                                for (auto multiCore : multiCoreModes)
+                                    for (auto os : oversamplingChoices)
+                                        configs.push_back({ voices, block, rate, wave, gobbler, wet, multiCore, os });
+    }
+    else
+    {
+        // Sweep one axis at a time around the baseline configuration.
+        for (auto voices : voiceCounts)    { auto c = baseline; c.numVoices = voices;     configs.push_back(c); }
+        for (auto block : blockSizes)      { auto c = baseline; c.blockSize = block;      configs.push_back(c); }
+        for (auto rate : sampleRates)      { auto c = baseline; c.sampleRate = rate;      configs.push_back(c); }
+        for (auto wave : waves)            { auto c = baseline; c.wave = wave;            configs.push_back(c); }
+        for (auto gobbler : gobblerAmounts){ auto c = baseline; c.gobblerAmount = gobbler; configs.push_back(c); }
+        for (auto wet : reverbWetLevels)   { auto c = baseline; c.reverbWetLevel = wet;   configs.push_back(c); }
+        for (auto mc : multiCoreModes)     { auto c = baseline; c.multiCore = mc;         configs.push_back(c); }
+        if (oversamplingChoices.size() > 1)
+            for (auto os : oversamplingChoices){ auto c = baseline; c.oversampling = os;  configs.push_back(c); }
+    }
+
+    printHeader(csv);
+
+    for (const auto& config : configs)
+        printResult(config, runConfig(config, secondsToRender, offline), csv);
+
+    return 0;
+}
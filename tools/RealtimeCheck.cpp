@@ -0,0 +1,175 @@
+#include "PluginProcessor.hpp"
+#include "RealtimeSanitizer.hpp"
+
+#include <cstdio>
+
+/**
+ * @file RealtimeCheck.cpp
+ * @brief Runs processBlock under the RealtimeSanitizer and fails on any real-time safety violation.
+ *
+ * Drives a CantinaComposerAudioProcessor through a script of notes, controller
+ * messages and parameter changes that reaches every stage of the chain: both
+ * reverb engines, every oversampling factor, the distortion, the voice and bus
+ * filters, pitch changes and bends, unison stacks, voice stealing, the
+ * multi-timbral layers and the multi-core voice path. Only the processBlock
+ * calls run inside a real-time scope. Parameter changes happen between blocks,
+ * as a host would make them from another thread.
+ *
+ * Violations of the worker threads of the voice pool are not checked, only
+ * those of the thread that calls processBlock.
+ *
+ * Usage: CantinaComposerRealtimeCheck [--suppressions <file>] [--seconds <n>]
+ *   --suppressions  A file with one "function:frame" suppression per line; '#' starts a comment.
+ *   --seconds       Audio seconds rendered per scenario (default 8).
+ *
+ * Exits with 1 if any violation was not suppressed.
+ */
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+
+    void setParameter(juce::AudioProcessorValueTreeState& apvts, const juce::String& parameterID, float value)
+    {
+        auto* param = apvts.getParameter(parameterID);
+        jassert(param != nullptr);
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+    }
+
+    juce::StringArray loadSuppressions(const juce::File& file)
+    {
+        juce::StringArray suppressions;
+
+        for (auto line : juce::StringArray::fromLines(file.loadFileAsString()))
+        {
+            line = line.upToFirstOccurrenceOf("#", false, false).trim();
+            if (line.isNotEmpty())
+                suppressions.add(line);
+        }
+
+        return suppressions;
+    }
+
+    /** @brief Renders one scenario, with the voice pool enabled or not. */
+    void runScenario(bool multiCore, double secondsToRender)
+    {
+        CantinaComposerAudioProcessor processor;
+        auto& apvts = processor.apvts;
+
+        // The pool is created in prepareToPlay, there is no message loop to do it later.
+        setParameter(apvts, "MULTICORE", multiCore ? 1.0f : 0.0f);
+        setParameter(apvts, "POLYPHONY", 16.0f);
+
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer(processor.getTotalNumOutputChannels(), blockSize);
+        juce::MidiBuffer midi;
+
+        // Warm up outside of the scope: the convolution engine loads its responses on a
+        // background thread, and every engine gets to run once in both reverb modes.
+        for (int mode = 0; mode < 2; ++mode)
+        {
+            setParameter(apvts, "REVERB_MODE", (float) mode);
+            for (int i = 0; i < 50; ++i)
+            {
+                processor.processBlock(buffer, midi);
+                juce::Thread::sleep(5);
+            }
+        }
+
+        const auto blocksPerSecond = juce::roundToInt(sampleRate / blockSize);
+        const auto numBlocks = juce::jmax(1, juce::roundToInt(secondsToRender * blocksPerSecond));
+        juce::Random random(1234);
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            // Everything the host does between blocks happens outside of the scope.
+            midi.clear();
+
+            if (block % 8 == 0)
+            {
+                // Chords of up to 24 notes steal voices once they exceed the polyphony.
+                const auto numNotes = 1 + random.nextInt(24);
+                for (int n = 0; n < numNotes; ++n)
+                    midi.addEvent(juce::MidiMessage::noteOn(1 + random.nextInt(4), 24 + random.nextInt(84), 0.2f + 0.8f * random.nextFloat()),
+                                  random.nextInt(blockSize));
+            }
+            if (block % 8 == 5)
+                for (int channel = 1; channel <= 4; ++channel)
+                    for (int note = 0; note < 128; ++note)
+                        midi.addEvent(juce::MidiMessage::noteOff(channel, note), random.nextInt(blockSize));
+            if (block % 32 == 3)
+                midi.addEvent(juce::MidiMessage::controllerEvent(1, 64, 127), 0);
+            if (block % 32 == 20)
+                midi.addEvent(juce::MidiMessage::controllerEvent(1, 64, 0), blockSize / 2);
+            if (block % 64 == 63)
+                midi.addEvent(juce::MidiMessage::allNotesOff(1), blockSize - 1);
+            if (block % 4 == 2)
+                midi.addEvent(juce::MidiMessage::pitchWheel(1 + random.nextInt(4), random.nextInt(16384)), random.nextInt(blockSize));
+
+            // Walk the parameters that change what processBlock does.
+            if (block % 16 == 0)
+            {
+                const auto step = block / 16;
+                setParameter(apvts, "WAVE", (float) (step % 3));
+                setParameter(apvts, "REVERB_MODE", (float) ((step / 3) % 2));
+                setParameter(apvts, "OVERSAMPLING", (float) ((step / 6) % 4));
+                setParameter(apvts, "JIZZ_GOBBLER_AMOUNT", (step % 5) * 0.25f);
+                setParameter(apvts, "POLYPHONY", step % 7 == 0 ? 2.0f : 16.0f);
+                setParameter(apvts, "MULTITIMBRAL", (step / 4) % 2 == 1 ? 1.0f : 0.0f);
+                setParameter(apvts, "UNISON", (float) (1 + (step * 5) % VoiceBank::maxUnison));
+            }
+
+            setParameter(apvts, "FILTER_FREQ", 20.0f + 19980.0f * random.nextFloat());
+            setParameter(apvts, "BASS_GAIN", -24.0f + 48.0f * random.nextFloat());
+            setParameter(apvts, "PITCH", -12.0f + 24.0f * random.nextFloat());
+            setParameter(apvts, "REVERB_ROOM_SIZE", random.nextFloat());
+            setParameter(apvts, "REVERB_WET_LEVEL", random.nextFloat());
+            setParameter(apvts, "REVERB_DAMPING", random.nextFloat());
+            setParameter(apvts, "REVERB_WIDTH", random.nextFloat());
+            setParameter(apvts, "OUTPUT_LEVEL", -48.0f + 54.0f * random.nextFloat());
+            setParameter(apvts, "SUSTAIN", random.nextFloat());
+            setParameter(apvts, "VOICE_CUTOFF", 20.0f + 19980.0f * random.nextFloat());
+            setParameter(apvts, "VOICE_ENV_AMOUNT", 8.0f * random.nextFloat());
+
+            RealtimeSanitizer::ScopedRealtime realtime;
+            processor.processBlock(buffer, midi);
+        }
+
+        processor.releaseResources();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    RealtimeSanitizer::initialise();
+
+    juce::StringArray suppressions;
+    double secondsToRender = 8.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+
+        if (arg == "--suppressions" && i + 1 < argc)
+            suppressions = loadSuppressions(juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]));
+        else if (arg == "--seconds" && i + 1 < argc)
+            secondsToRender = juce::jmax(0.1, juce::String(argv[++i]).getDoubleValue());
+        else
+        {
+            std::printf("Usage: %s [--suppressions <file>] [--seconds <n>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    runScenario(false, secondsToRender);
+    runScenario(true, secondsToRender);
+
+    const auto numUnexpected = RealtimeSanitizer::report(suppressions);
+    std::printf("%d real-time violation(s), %d unexpected.\n", RealtimeSanitizer::getNumViolations(), numUnexpected);
+
+    return numUnexpected > 0 ? 1 : 0;
+}
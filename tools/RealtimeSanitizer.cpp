@@ -0,0 +1,308 @@
+#include "RealtimeSanitizer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+// glibc's own entry points of its allocator. Forwarding to them instead of dlsym(RTLD_NEXT, "malloc")
+// avoids the chicken-and-egg problem of dlsym allocating while malloc is being resolved.
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* pointer);
+}
+
+namespace
+{
+    constexpr int maxFrames = 32;
+    constexpr int maxRecords = 256;
+    /// @brief The recorder's own frames (recordViolation and the interposed function), skipped when printing.
+    constexpr int sanitizerFrames = 2;
+    /// @brief How deep into the stack a suppression's frame text may match.
+    constexpr int suppressionDepth = 4;
+
+    struct Record
+    {
+        const char* function;
+        int numFrames;
+        void* frames[maxFrames];
+        int hits;
+    };
+
+    /// @brief Filled by the one real-time thread under test, read by report() afterwards.
+    Record records[maxRecords];
+    int numRecords = 0;
+    int numDropped = 0;
+
+    thread_local int realtimeDepth = 0;
+    /// @brief Set while a violation is being recorded, so the stack walker's own calls don't count.
+    thread_local bool recording = false;
+    std::atomic<bool> initialised { false };
+
+    void recordViolation(const char* function) noexcept
+    {
+        if (realtimeDepth == 0 || recording || ! initialised.load(std::memory_order_relaxed))
+            return;
+
+        recording = true;
+
+        void* frames[maxFrames];
+        const auto numFrames = backtrace(frames, maxFrames);
+
+        // The same call from the same place counts once, however many blocks it happens in.
+        for (int i = 0; i < numRecords; ++i)
+        {
+            auto& record = records[i];
+            if (record.function == function && record.numFrames == numFrames
+                && std::memcmp(record.frames, frames, sizeof(void*) * (size_t) numFrames) == 0)
+            {
+                ++record.hits;
+                recording = false;
+                return;
+            }
+        }
+
+        if (numRecords < maxRecords)
+        {
+            auto& record = records[numRecords++];
+            record.function = function;
+            record.numFrames = numFrames;
+            std::memcpy(record.frames, frames, sizeof(void*) * (size_t) numFrames);
+            record.hits = 1;
+        }
+        else
+        {
+            ++numDropped;
+        }
+
+        recording = false;
+    }
+
+    /** @brief Looks a function up in the next library once; later calls return the cached pointer. */
+    template <typename Function>
+    Function resolve(std::atomic<Function>& slot, const char* name) noexcept
+    {
+        auto function = slot.load(std::memory_order_acquire);
+        if (function == nullptr)
+        {
+            function = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+            slot.store(function, std::memory_order_release);
+        }
+        return function;
+    }
+
+    std::atomic<int (*)(pthread_mutex_t*)> realMutexLock { nullptr };
+    std::atomic<int (*)(pthread_cond_t*, pthread_mutex_t*)> realCondWait { nullptr };
+    std::atomic<ssize_t (*)(int, void*, size_t)> realRead { nullptr };
+    std::atomic<ssize_t (*)(int, const void*, size_t)> realWrite { nullptr };
+    std::atomic<int (*)(const char*, int, ...)> realOpen { nullptr };
+    std::atomic<int (*)(const timespec*, timespec*)> realNanosleep { nullptr };
+    std::atomic<int (*)(useconds_t)> realUsleep { nullptr };
+
+    /** @brief Turns one line of backtrace_symbols() into "module: demangled+offset". */
+    juce::String describeFrame(const char* symbol)
+    {
+        const juce::String line(symbol);
+        const auto open = line.indexOfChar('(');
+        const auto plus = line.indexOfChar(open, '+');
+
+        if (open < 0 || plus <= open + 1)
+            return line;
+
+        const auto mangled = line.substring(open + 1, plus);
+        int status = 0;
+        auto* demangled = abi::__cxa_demangle(mangled.toRawUTF8(), nullptr, nullptr, &status);
+        const auto name = status == 0 && demangled != nullptr ? juce::String(demangled) : mangled;
+        std::free(demangled);
+
+        return name + "  [" + line.substring(0, open) + "]";
+    }
+}
+
+//==============================================================================
+// The interposed functions. They only add a check in front of the real thing.
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        recordViolation("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        recordViolation("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        recordViolation("realloc");
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer)
+    {
+        if (pointer != nullptr)
+            recordViolation("free");
+        __libc_free(pointer);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        recordViolation("memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        recordViolation("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size)
+    {
+        recordViolation("posix_memalign");
+        *result = __libc_memalign(alignment, size);
+        return *result != nullptr || size == 0 ? 0 : ENOMEM;
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        recordViolation("pthread_mutex_lock");
+        return resolve(realMutexLock, "pthread_mutex_lock")(mutex);
+    }
+
+    int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+    {
+        recordViolation("pthread_cond_wait");
+        return resolve(realCondWait, "pthread_cond_wait")(condition, mutex);
+    }
+
+    ssize_t read(int fd, void* buffer, size_t count)
+    {
+        recordViolation("read");
+        return resolve(realRead, "read")(fd, buffer, count);
+    }
+
+    ssize_t write(int fd, const void* buffer, size_t count)
+    {
+        recordViolation("write");
+        return resolve(realWrite, "write")(fd, buffer, count);
+    }
+
+    int open(const char* path, int flags, ...)
+    {
+        recordViolation("open");
+
+        mode_t mode = 0;
+        if ((flags & O_CREAT) != 0)
+        {
+            va_list args;
+            va_start(args, flags);
+            mode = (mode_t) va_arg(args, int);
+            va_end(args);
+        }
+
+        return resolve(realOpen, "open")(path, flags, mode);
+    }
+
+    int nanosleep(const timespec* duration, timespec* remaining)
+    {
+        recordViolation("nanosleep");
+        return resolve(realNanosleep, "nanosleep")(duration, remaining);
+    }
+
+    int usleep(useconds_t microseconds)
+    {
+        recordViolation("usleep");
+        return resolve(realUsleep, "usleep")(microseconds);
+    }
+}
+
+//==============================================================================
+namespace RealtimeSanitizer
+{
+    void initialise()
+    {
+        // Resolve everything now, so the first call inside a scope doesn't have to.
+        resolve(realMutexLock, "pthread_mutex_lock");
+        resolve(realCondWait, "pthread_cond_wait");
+        resolve(realRead, "read");
+        resolve(realWrite, "write");
+        resolve(realOpen, "open");
+        resolve(realNanosleep, "nanosleep");
+        resolve(realUsleep, "usleep");
+
+        // The first backtrace() loads the unwinder, which allocates.
+        void* frames[4];
+        backtrace(frames, 4);
+
+        initialised.store(true, std::memory_order_relaxed);
+    }
+
+    ScopedRealtime::ScopedRealtime() noexcept { ++realtimeDepth; }
+    ScopedRealtime::~ScopedRealtime() { --realtimeDepth; }
+
+    int getNumViolations() noexcept { return numRecords; }
+
+    int report(const juce::StringArray& suppressions)
+    {
+        int numUnsuppressed = 0;
+
+        for (int i = 0; i < numRecords; ++i)
+        {
+            const auto& record = records[i];
+            auto* symbols = backtrace_symbols(record.frames, record.numFrames);
+
+            juce::StringArray stack;
+            for (int f = sanitizerFrames; f < record.numFrames; ++f)
+                stack.add(symbols != nullptr ? describeFrame(symbols[f]) : juce::String::toHexString((juce::pointer_sized_int) record.frames[f]));
+            std::free(symbols);
+
+            const auto isSuppressed = std::any_of(suppressions.begin(), suppressions.end(), [&](const juce::String& suppression)
+            {
+                if (suppression.upToFirstOccurrenceOf(":", false, false) != record.function)
+                    return false;
+
+                const auto frameText = suppression.fromFirstOccurrenceOf(":", false, false);
+                for (int f = 0; f < juce::jmin(suppressionDepth, stack.size()); ++f)
+                    if (stack[f].contains(frameText))
+                        return true;
+                return false;
+            });
+
+            std::fprintf(stderr, "%s real-time violation: %s (%d time%s)\n", isSuppressed ? "Suppressed" : "UNEXPECTED",
+                         record.function, record.hits, record.hits == 1 ? "" : "s");
+
+            if (! isSuppressed)
+            {
+                ++numUnsuppressed;
+                for (const auto& frame : stack)
+                    std::fprintf(stderr, "    %s\n", frame.toRawUTF8());
+            }
+        }
+
+        if (numDropped > 0)
+        {
+            std::fprintf(stderr, "%d more violation(s) did not fit the table.\n", numDropped);
+            numUnsuppressed += numDropped;
+        }
+
+        return numUnsuppressed;
+    }
+}
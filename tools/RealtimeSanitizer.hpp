@@ -0,0 +1,50 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+/**
+ * @file RealtimeSanitizer.hpp
+ * @brief Catches heap allocations, locks and blocking system calls on a thread while it is marked real-time.
+ *
+ * Linking RealtimeSanitizer.cpp into an executable replaces malloc and friends
+ * and interposes pthread_mutex_lock, pthread_cond_wait, read, write, open,
+ * nanosleep and usleep. Each of them first checks whether the calling thread is
+ * inside a ScopedRealtime and, if so, records a violation with its call stack
+ * before forwarding to the real function. operator new and delete end up in
+ * malloc and free, so they are covered as well. Outside of a scope the cost is
+ * one thread-local read per call.
+ *
+ * Recording never allocates: violations go into a fixed table, and the same
+ * function with the same stack only increments a counter. Symbols are looked
+ * up only when report() prints them. Linux and glibc only.
+ */
+namespace RealtimeSanitizer
+{
+    /** @brief Resolves the real functions and warms up the stack walker. Call once, before any scope. */
+    void initialise();
+
+    /**
+     * @class ScopedRealtime
+     * @brief Marks the calling thread as real-time for the lifetime of the object.
+     */
+    class ScopedRealtime
+    {
+    public:
+        ScopedRealtime() noexcept;
+        ~ScopedRealtime();
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedRealtime)
+    };
+
+    /** @brief Returns the number of distinct violations (function and call stack) recorded so far. */
+    int getNumViolations() noexcept;
+
+    /**
+     * @brief Prints every recorded violation with its symbolised call stack.
+     *
+     * A suppression has the form "function:frame", e.g. "pthread_mutex_lock:VoiceRenderPool::run".
+     * It matches a violation of that function when one of the innermost few frames of its
+     * stack contains the frame text. Suppressed violations are listed, but not counted.
+     * @return The number of violations that no suppression matched.
+     */
+    int report(const juce::StringArray& suppressions);
+}
@@ -0,0 +1,386 @@
+#include "PluginProcessor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+/**
+ * @file Render.cpp
+ * @brief Headless renderer from a Standard MIDI File to WAV or FLAC.
+ *
+ * Every MIDI track that contains notes gets its own CantinaComposerAudioProcessor
+ * in offline mode. The tracks render in parallel, one second at a time, and each
+ * second is mixed and handed to a streaming writer on a background I/O thread, so
+ * memory stays bounded and the disk never holds up the render.
+ *
+ * Usage: CantinaComposerRender <input.mid> <output.wav|.flac> [options]
+ *   --rate <hz>       Sample rate (default 48000).
+ *   --block <n>       Block size the processors are driven with (default 1024).
+ *   --bits <n>        16, 24 or 32 (32 is float, WAV only). Default 24.
+ *   --preset <name>   A preset of the library by name, or its index.
+ *   --bank <file>     Opens this preset bank instead of the default one.
+ *   --state <file>    A saved plugin state (binary chunk or legacy XML), applied before the preset.
+ *   --tail <seconds>  Audio rendered after the last event (default: the patch's tail length).
+ *   --stems <dir>     Also writes every track on its own into this folder.
+ */
+
+namespace
+{
+    struct RenderOptions
+    {
+        juce::File input, output, stemDirectory, stateFile, bankFile;
+        double sampleRate = 48000.0;
+        int blockSize = 1024;
+        int bitsPerSample = 24;
+        juce::String preset;
+        double tailSeconds = -1.0;
+    };
+
+    /// @brief The length of the segments the tracks render in lockstep.
+    constexpr double segmentSeconds = 1.0;
+    /// @brief The samples each streaming writer may buffer ahead of the disk.
+    constexpr int writerBufferSamples = 1 << 18;
+    constexpr int numOutputChannels = 2;
+
+    /** @brief Creates a writer for a file, picking the format from its extension. Returns nullptr on failure. */
+    std::unique_ptr<juce::AudioFormatWriter> createWriter(juce::AudioFormatManager& formats, const juce::File& file,
+                                                          double sampleRate, int bitsPerSample)
+    {
+        auto* format = formats.findFormatForFileExtension(file.getFileExtension());
+        if (format == nullptr)
+            return nullptr;
+
+        file.deleteFile();
+        auto stream = std::make_unique<juce::FileOutputStream>(file);
+        if (! stream->openedOk())
+            return nullptr;
+
+        std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), sampleRate, numOutputChannels,
+                                                                                bitsPerSample, {}, 0));
+        if (writer != nullptr)
+            stream.release(); // The writer owns the stream now.
+
+        return writer;
+    }
+
+    /** @brief Hands samples to a streaming writer, waiting while its buffer is full. */
+    void writeBlocking(juce::AudioFormatWriter::ThreadedWriter& writer, const float* const* data, int numSamples)
+    {
+        while (! writer.write(data, numSamples))
+            juce::Thread::sleep(1);
+    }
+
+    /**
+     * @class TrackRenderer
+     * @brief One MIDI track with its own processor, rendered one segment at a time.
+     */
+    class TrackRenderer
+    {
+    public:
+        TrackRenderer(const juce::MidiMessageSequence& track, const RenderOptions& options, int trackIndex)
+            : index(trackIndex), blockSize(options.blockSize)
+        {
+            // Event times are seconds by now; the processor wants samples.
+            for (const auto* event : track)
+            {
+                if (event->message.isMetaEvent() || event->message.isSysEx())
+                    continue;
+
+                const auto position = (juce::int64) std::llround(event->message.getTimeStamp() * options.sampleRate);
+                events.push_back({ position, event->message });
+                lastEventSample = juce::jmax(lastEventSample, position);
+            }
+        }
+
+        bool hasNotes() const noexcept
+        {
+            return std::any_of(events.begin(), events.end(), [](const auto& e) { return e.message.isNoteOn(); });
+        }
+
+        /** @brief Creates and prepares the processor. Returns an error message, or an empty string. */
+        juce::String prepare(const RenderOptions& options, int workersPerTrack)
+        {
+            processor = std::make_unique<CantinaComposerAudioProcessor>();
+            processor->setNonRealtime(true);
+            processor->setOfflineWorkerLimit(workersPerTrack);
+            processor->setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+            processor->prepareToPlay(options.sampleRate, options.blockSize);
+
+            // The state and the preset replace what the fresh instance started with.
+            if (options.stateFile != juce::File())
+            {
+                juce::MemoryBlock state;
+                if (! options.stateFile.loadFileAsData(state))
+                    return "Can't read " + options.stateFile.getFullPathName();
+                processor->setStateInformation(state.getData(), (int) state.getSize());
+            }
+
+            if (options.preset.isNotEmpty())
+            {
+                auto& library = processor->getPresetLibrary();
+                if (options.bankFile != juce::File() && ! library.openBank(options.bankFile))
+                    return "Not a valid preset bank: " + options.bankFile.getFullPathName();
+
+                auto presetIndex = library.findByName(options.preset.toStdString());
+                if (presetIndex < 0 && options.preset.containsOnly("0123456789"))
+                    presetIndex = options.preset.getIntValue();
+
+                if (! library.applyPreset(presetIndex))
+                    return "Unknown preset: " + options.preset;
+            }
+
+            segment.setSize(numOutputChannels, juce::roundToInt(segmentSeconds * options.sampleRate));
+            return {};
+        }
+
+        juce::int64 getLastEventSample() const noexcept { return lastEventSample; }
+        double getTailLengthSeconds() const { return processor->getTailLengthSeconds(); }
+        int getLatencySamples() const { return processor->getLatencySamples(); }
+        int getIndex() const noexcept { return index; }
+        const juce::AudioBuffer<float>& getSegment() const noexcept { return segment; }
+
+        /** @brief Renders the next numSamples samples (at most one segment) into getSegment(). */
+        void renderSegment(juce::int64 segmentStart, int numSamples)
+        {
+            for (int offset = 0; offset < numSamples; offset += blockSize)
+            {
+                const auto blockStart = segmentStart + offset;
+                const auto length = juce::jmin(blockSize, numSamples - offset);
+
+                midi.clear();
+                while (nextEvent < events.size() && events[nextEvent].position < blockStart + length)
+                {
+                    const auto& event = events[nextEvent++];
+                    midi.addEvent(event.message, (int) juce::jmax((juce::int64) 0, event.position - blockStart));
+                }
+
+                juce::AudioBuffer<float> block(segment.getArrayOfWritePointers(), numOutputChannels, offset, length);
+                processor->processBlock(block, midi);
+            }
+        }
+
+    private:
+        struct Event
+        {
+            juce::int64 position;
+            juce::MidiMessage message;
+        };
+
+        int index;
+        int blockSize;
+        std::vector<Event> events;
+        size_t nextEvent = 0;
+        juce::int64 lastEventSample = 0;
+
+        std::unique_ptr<CantinaComposerAudioProcessor> processor;
+        juce::AudioBuffer<float> segment;
+        juce::MidiBuffer midi;
+    };
+
+    bool parseArguments(int argc, char* argv[], RenderOptions& options)
+    {
+        juce::StringArray positional;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const juce::String arg(argv[i]);
+            const auto hasValue = i + 1 < argc;
+
+            if (arg == "--rate" && hasValue)         options.sampleRate = juce::String(argv[++i]).getDoubleValue();
+            else if (arg == "--block" && hasValue)   options.blockSize = juce::String(argv[++i]).getIntValue();
+            else if (arg == "--bits" && hasValue)    options.bitsPerSample = juce::String(argv[++i]).getIntValue();
+            else if (arg == "--preset" && hasValue)  options.preset = juce::String(argv[++i]);
+            else if (arg == "--bank" && hasValue)    options.bankFile = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+            else if (arg == "--state" && hasValue)   options.stateFile = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+            else if (arg == "--tail" && hasValue)    options.tailSeconds = juce::String(argv[++i]).getDoubleValue();
+            else if (arg == "--stems" && hasValue)   options.stemDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+            else if (! arg.startsWith("--"))         positional.add(arg);
+            else                                     return false;
+        }
+
+        if (positional.size() != 2 || options.sampleRate < 8000.0 || options.blockSize < 1)
+            return false;
+
+        options.input = juce::File::getCurrentWorkingDirectory().getChildFile(positional[0]);
+        options.output = juce::File::getCurrentWorkingDirectory().getChildFile(positional[1]);
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    RenderOptions options;
+    if (! parseArguments(argc, argv, options))
+    {
+        std::printf("Usage: %s <input.mid> <output.wav|.flac> [--rate <hz>] [--block <n>] [--bits <16|24|32>]\n"
+                    "       [--preset <name|index>] [--bank <file>] [--state <file>] [--tail <seconds>] [--stems <dir>]\n",
+                    argv[0]);
+        return 1;
+    }
+
+    // --- Read the MIDI file ---
+    juce::MidiFile midiFile;
+    {
+        juce::FileInputStream stream(options.input);
+        if (! stream.openedOk() || ! midiFile.readFrom(stream))
+        {
+            std::printf("Can't read MIDI file %s\n", options.input.getFullPathName().toRawUTF8());
+            return 1;
+        }
+    }
+    midiFile.convertTimestampTicksToSeconds();
+
+    std::vector<std::unique_ptr<TrackRenderer>> tracks;
+    for (int t = 0; t < midiFile.getNumTracks(); ++t)
+    {
+        auto track = std::make_unique<TrackRenderer>(*midiFile.getTrack(t), options, t);
+        if (track->hasNotes())
+            tracks.push_back(std::move(track));
+    }
+
+    if (tracks.empty())
+    {
+        std::printf("No notes in %s\n", options.input.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    // --- One processor per track; the cores are shared between the tracks and their voice workers ---
+    const auto numCpus = juce::SystemStats::getNumCpus();
+    const auto numRenderThreads = juce::jmin((int) tracks.size(), numCpus);
+    const auto workersPerTrack = juce::jmax(0, numCpus / (int) tracks.size() - 1);
+
+    for (auto& track : tracks)
+    {
+        if (const auto error = track->prepare(options, workersPerTrack); error.isNotEmpty())
+        {
+            std::printf("%s\n", error.toRawUTF8());
+            return 1;
+        }
+    }
+
+    // All processors run the same chain, so they share one latency, which is cut off the front.
+    const auto latency = tracks.front()->getLatencySamples();
+    juce::int64 lastEventSample = 0;
+    double tailSeconds = options.tailSeconds;
+    for (const auto& track : tracks)
+    {
+        lastEventSample = juce::jmax(lastEventSample, track->getLastEventSample());
+        if (options.tailSeconds < 0.0)
+            tailSeconds = juce::jmax(tailSeconds, track->getTailLengthSeconds());
+    }
+
+    const auto outputLength = lastEventSample + (juce::int64) std::llround(juce::jmax(0.0, tailSeconds) * options.sampleRate);
+    const auto renderLength = outputLength + latency;
+
+    // --- Streaming writers on one background I/O thread ---
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    juce::TimeSliceThread ioThread("CantinaComposer Render I/O");
+    ioThread.startThread();
+
+    auto makeThreadedWriter = [&](const juce::File& file) -> std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter>
+    {
+        auto writer = createWriter(formats, file, options.sampleRate, options.bitsPerSample);
+        if (writer == nullptr)
+            return nullptr;
+        return std::make_unique<juce::AudioFormatWriter::ThreadedWriter>(writer.release(), ioThread, writerBufferSamples);
+    };
+
+    auto mixWriter = makeThreadedWriter(options.output);
+    if (mixWriter == nullptr)
+    {
+        std::printf("Can't write %s (.wav or .flac, %d bits)\n", options.output.getFullPathName().toRawUTF8(), options.bitsPerSample);
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter>> stemWriters;
+    if (options.stemDirectory != juce::File())
+    {
+        options.stemDirectory.createDirectory();
+        for (const auto& track : tracks)
+        {
+            const auto name = options.output.getFileNameWithoutExtension() + "-track" + juce::String(track->getIndex() + 1)
+                            + options.output.getFileExtension();
+            stemWriters.push_back(makeThreadedWriter(options.stemDirectory.getChildFile(name)));
+            if (stemWriters.back() == nullptr)
+            {
+                std::printf("Can't write stems into %s\n", options.stemDirectory.getFullPathName().toRawUTF8());
+                return 1;
+            }
+        }
+    }
+
+    // --- Render the tracks in parallel, one segment at a time, and mix ---
+    juce::ThreadPool renderThreads(juce::ThreadPoolOptions().withThreadName("CantinaComposer Render").withNumberOfThreads(numRenderThreads));
+    const auto segmentSamples = tracks.front()->getSegment().getNumSamples();
+    juce::AudioBuffer<float> mix(numOutputChannels, segmentSamples);
+    float peak = 0.0f;
+
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    std::atomic<int> tracksLeft { 0 };
+    juce::WaitableEvent segmentDone;
+
+    for (juce::int64 position = 0; position < renderLength; position += segmentSamples)
+    {
+        const auto numSamples = (int) juce::jmin((juce::int64) segmentSamples, renderLength - position);
+
+        tracksLeft = (int) tracks.size();
+        for (auto& track : tracks)
+        {
+            renderThreads.addJob([&track, &tracksLeft, &segmentDone, position, numSamples]
+            {
+                track->renderSegment(position, numSamples);
+                if (--tracksLeft == 0)
+                    segmentDone.signal();
+            });
+        }
+        segmentDone.wait();
+
+        // Mixing and writing follow the track order, so the result doesn't depend on the threads.
+        mix.clear();
+        for (size_t t = 0; t < tracks.size(); ++t)
+        {
+            const auto& segment = tracks[t]->getSegment();
+            for (int channel = 0; channel < numOutputChannels; ++channel)
+                mix.addFrom(channel, 0, segment, channel, 0, numSamples);
+        }
+
+        // The first latency samples are the chain's delay, not music.
+        const auto skip = (int) juce::jlimit((juce::int64) 0, (juce::int64) numSamples, (juce::int64) latency - position);
+        if (skip < numSamples)
+        {
+            const float* mixChannels[numOutputChannels] = { mix.getReadPointer(0, skip), mix.getReadPointer(1, skip) };
+            writeBlocking(*mixWriter, mixChannels, numSamples - skip);
+            peak = juce::jmax(peak, mix.getMagnitude(skip, numSamples - skip));
+
+            for (size_t t = 0; t < stemWriters.size(); ++t)
+            {
+                const auto& segment = tracks[t]->getSegment();
+                const float* stemChannels[numOutputChannels] = { segment.getReadPointer(0, skip), segment.getReadPointer(1, skip) };
+                writeBlocking(*stemWriters[t], stemChannels, numSamples - skip);
+            }
+        }
+    }
+
+    // Destroying the threaded writers flushes everything they still hold.
+    mixWriter.reset();
+    stemWriters.clear();
+    ioThread.stopThread(2000);
+
+    const auto renderSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+    const auto audioSeconds = (double) outputLength / options.sampleRate;
+    std::printf("Rendered %d track(s), %.1f s of audio in %.2f s (%.1fx realtime), peak %.1f dBFS\n",
+                (int) tracks.size(), audioSeconds, renderSeconds, renderSeconds > 0.0 ? audioSeconds / renderSeconds : 0.0,
+                juce::Decibels::gainToDecibels(peak));
+
+    if (peak > 1.0f && options.bitsPerSample < 32)
+        std::printf("Warning: the mix clips. Use --bits 32 or lower the patch levels.\n");
+
+    return 0;
+}